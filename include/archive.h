@@ -0,0 +1,59 @@
+#ifndef HW3_ARCHIVE_H
+#define HW3_ARCHIVE_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+// Read-only private mapping of a whole file, unmapped on destruction. Windows has no mmap, so
+// there the file is read into memory that the object owns.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& file_name);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return begin; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* begin = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    std::vector<char> contents;
+#endif
+};
+
+// Seekable input buffer over bytes owned by someone else, so that a member of a mapped archive can be
+// parsed by the stream based readers without a copy.
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(const char* data, std::size_t size);
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
+
+struct ArchiveMember {
+    std::string name;
+    std::size_t offset;  // of the data, from the start of the archive
+    std::size_t size;
+};
+
+const char ARCHIVE_MAGIC[] = "!<arch>\n";
+const std::size_t ARCHIVE_MAGIC_SIZE = 8;
+
+bool is_archive(std::istream& in);
+
+// Members of a System V / GNU ar archive in archive order, with "/123" names resolved through the
+// "//" long-name table and BSD "#1/N" names read from the member data. Symbol indexes are skipped.
+std::vector<ArchiveMember> read_archive_members(const char* data, std::size_t size);
+
+}
+
+#endif
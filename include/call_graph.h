@@ -0,0 +1,69 @@
+#ifndef HW3_CALL_GRAPH_H
+#define HW3_CALL_GRAPH_H
+
+#include "code.h"
+#include "options.h"
+#include "symbols.h"
+#include <iosfwd>
+#include <vector>
+
+namespace Parser {
+
+struct CallSite {
+    std::uint32_t address;
+    std::size_t callee;  // index into the functions
+    bool tail;           // jump without link: the callee returns straight to our caller
+};
+
+// Direct calls of every function, indexed like the functions they were built from.
+struct CallGraph {
+    std::vector<std::vector<CallSite>> calls;
+    // jalr that links ra through an unknown register, or a jump through a register other than ra;
+    // char rather than bool so that functions can be filled from different threads
+    std::vector<char> indirect;
+};
+
+// commands of functions[i] in its section, decoded in address order; empty outside of code
+struct FunctionCode {
+    const CodeSection* section = nullptr;
+    std::uint32_t first = 0;  // command ordinals [first, last)
+    std::uint32_t last = 0;
+};
+
+FunctionCode get_function_code(const std::vector<Function>& functions, std::size_t i,
+                               const std::vector<CodeSection>& code);
+
+// index of the function holding address, or functions.size()
+std::size_t find_function_index(const std::vector<Function>& functions, std::uint32_t address);
+
+// Resolves branch, call and address targets found in the code of a section. Sections of a relocatable
+// file all start at 0, so there a target only matches functions of the section it was found in.
+class FunctionLookup {
+public:
+    explicit FunctionLookup(const std::vector<Function>& functions);
+
+    // index of the function holding address, or functions.size()
+    std::size_t find(std::uint32_t address, const CodeSection& section) const;
+
+    // function a branch, jump or call at `offset` of section goes to: the target of its relocation if
+    // it has one, which for an undefined symbol is no function, otherwise the encoded `target`
+    std::size_t find_target(const CodeSection& section, std::uint32_t offset, std::uint32_t target) const;
+
+private:
+    std::size_t find_in_section(std::uint32_t section, std::uint32_t address) const;
+
+    const std::vector<Function>& functions;
+    std::vector<std::size_t> by_section;  // function indexes sorted by (section, address)
+};
+
+// jal/c.jal calls, auipc+jalr pairs with a known target and tail jumps (j, c.j, auipc+jalr x0) into
+// another function, scanned per function on `jobs` threads
+CallGraph build_call_graph(const std::vector<Function>& functions, const std::vector<CodeSection>& code,
+                           unsigned jobs = 1);
+
+// prints the call graph with the number of call sites on every edge as Graphviz DOT or JSON
+void export_call_graph(std::istream& in, std::ostream& out, CallGraphFormat format, unsigned jobs);
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef HW3_CODE_H
+#define HW3_CODE_H
+
+#include "elf_parser.h"
+#include "instruction_index.h"
+#include "symbols.h"
+#include <map>
+#include <vector>
+
+namespace Parser {
+
+// where a relocated branch, jump or call goes: address inside section, section 0 if undefined
+struct JumpTarget {
+    std::uint32_t section;
+    std::uint32_t address;
+};
+
+// contents of an executable section together with its command index
+struct CodeSection {
+    std::uint32_t id;
+    std::uint32_t address;
+    std::vector<char> data;
+    InstructionIndex index;
+    // sections of a relocatable file all start at 0, so only the section id tells them apart
+    bool relocatable = false;
+    // targets of the jump and call relocations by the offset of the command (the auipc of a call);
+    // the offsets encoded in such commands are still 0
+    std::map<std::uint32_t, JumpTarget> jumps;
+
+    bool contains(std::uint32_t adr) const { return adr - address < data.size(); }
+};
+
+// executable sections, decompressed and indexed on `jobs` threads, with the jump relocations of
+// relocatable files
+std::vector<CodeSection> load_code(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& section_headers,
+        unsigned jobs = 1
+);
+
+// section holding address, or nullptr
+const CodeSection* find_code(const std::vector<CodeSection>& code, std::uint32_t adr);
+
+// Section holding the code of function: the one its st_shndx names. In executables, where st_shndx
+// may name a section that is not loaded as code, any section holding its address. nullptr if none.
+const CodeSection* find_function_code(const std::vector<CodeSection>& code, const Function& function);
+
+// end of functions[i] inside its section; functions without a size extend to the next function of the section
+std::uint32_t get_function_end(const std::vector<Function>& functions, std::size_t i, const CodeSection& section);
+
+// format_insn, except that unknown commands show their bits
+std::string describe_insn(const DecodedInsn& insn, std::uint32_t adr, const std::map<std::uint32_t, std::string>& tags);
+
+// s with quotes, backslashes and control characters escaped for a JSON string literal
+std::string escape_json(const std::string& s);
+
+// s for a Graphviz quoted id: quotes and backslashes escaped, so that the name is not read as
+// a label escape like \n or \l, and line breaks as \n
+std::string escape_dot(const std::string& s);
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef HW3_COMPRESS_H
+#define HW3_COMPRESS_H
+
+#include "options.h"
+#include <cstdint>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+const std::size_t COMPRESSION_BLOCK_SIZE = 1 << 20;
+
+// throws if hw3 was built without the codec, so that callers can check before creating the output
+void check_compression(Compression compression);
+
+// Output buffer that cuts what is written into blocks of COMPRESSION_BLOCK_SIZE bytes and compresses
+// them into independent gzip members or zstd frames, which decompressors treat as one stream. Up to
+// `jobs` filled blocks are compressed together on `jobs` threads and written to `out` in order, so
+// memory stays bounded by the batch. finish() writes the rest; without it the tail is dropped.
+class CompressingBuffer : public std::streambuf {
+public:
+    CompressingBuffer(std::ostream& out, Compression compression, unsigned jobs);
+
+    void finish();
+
+protected:
+    int_type overflow(int_type c) override;
+    // only reports the position, in uncompressed bytes, so that tellp works for the line index
+    pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+private:
+    void start_block();
+    void write_blocks();
+
+    std::ostream& out;
+    Compression compression;
+    unsigned jobs;
+    std::vector<std::string> blocks;  // the last one is being filled
+    std::uint64_t before = 0;  // uncompressed bytes of the blocks before the last one
+    bool written = false;
+};
+
+// Inflates a zlib stream (is_zstd == false) or a zstd frame whose decompressed size is known
+// to be exactly `size` bytes. A size that data_size bytes can't reach under the format's maximum
+// ratio is rejected before anything is allocated.
+std::vector<char> decompress(const char* data, std::size_t data_size, std::size_t size, bool is_zstd);
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HW3_COVERAGE_H
+#define HW3_COVERAGE_H
+
+#include "options.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+// Merges the executed commands of all trace files (read in parallel on `jobs` threads) and prints
+// for every function the executed and total command counts, the executed address ranges and the
+// basic blocks no trace reached.
+void report_coverage(std::istream& in, std::ostream& out, const std::vector<std::string>& trace_file_names,
+                     TraceFormat format, unsigned jobs);
+
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HW3_DEAD_CODE_H
+#define HW3_DEAD_CODE_H
+
+#include <iosfwd>
+
+namespace Parser {
+
+// Marks the functions reachable from e_entry, global and weak functions and functions whose address
+// is built with lui, c.lui or auipc, following calls, jumps and address constants, and prints the others
+// with their sizes. References are collected per function on `jobs` threads.
+void report_unreferenced(std::istream& in, std::ostream& out, unsigned jobs);
+
+}
+
+#endif
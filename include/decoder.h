@@ -0,0 +1,82 @@
+#ifndef HW3_DECODER_H
+#define HW3_DECODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+enum class Op : std::uint8_t {
+    UNKNOWN,
+    C_ADDI4SPN, C_FLD, C_LD, C_FSD, C_LW, C_SW, C_FSW,
+    C_NOP, C_ADDI, C_JAL, C_LI, C_ADDI16SP, C_LUI, C_SRLI, C_SRAI, C_ANDI,
+    C_SUB, C_XOR, C_OR, C_AND, C_SUBW, C_ADDW, C_J, C_BEQZ, C_BNEZ,
+    C_SLLI, C_FLDSP, C_LWSP, C_FLWSP, C_ADD, C_MV, C_EBREAK, C_JR, C_JALR, C_FSDSP, C_SWSP, C_FSWSP,
+    LUI, AUIPC,
+    ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI,
+    ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND,
+    MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU,
+    LB, LH, LW, LBU, LHU, SB, SH, SW,
+    JAL, JALR, BEQ, BNE, BLT, BGE, BLTU, BGEU,
+    COUNT
+};
+
+// which operands are printed and in which order
+enum class Format : std::uint8_t {
+    NONE,               // c.nop
+    RS1,                // c.jr rs1
+    RD_RS2,             // c.mv rd, rs2
+    RD_IMM,             // lui rd, imm
+    RD_RS1_IMM,         // addi rd, rs1, imm
+    RD_RS1_RS2,         // add rd, rs1, rs2
+    LOAD,               // lw rd, imm(rs1)
+    STORE,              // sw rs2, imm(rs1)
+    JUMP,               // c.j target
+    RD_JUMP,            // jal rd, target
+    RS1_JUMP,           // c.beqz rs1, target
+    RS1_RS2_JUMP        // beq rs1, rs2, target
+};
+
+// A decoded command. Jump and branch targets are kept as offsets from the command in imm.
+struct DecodedInsn {
+    std::uint32_t raw = 0;      // command bits, the upper half is zero for 16-bit commands
+    std::uint8_t length = 2;
+    Op op = Op::UNKNOWN;
+    Format format = Format::NONE;
+    std::uint8_t rd = 0;
+    std::uint8_t rs1 = 0;
+    std::uint8_t rs2 = 0;
+    std::int32_t imm = 0;
+};
+
+// mask/match pair selecting the encodings of one command
+struct Pattern {
+    Op op;
+    std::uint32_t mask;
+    std::uint32_t match;
+};
+
+// Decodes the command in the low half of `word`, the upper half is used only by 32-bit commands.
+// Unsupported commands get Op::UNKNOWN and the length given by their two low bits.
+DecodedInsn decode(std::uint32_t word);
+
+// little-endian word starting at `offset`, zero-padded past the end of `code`
+std::uint32_t get_word(const std::vector<char>& code, std::uint32_t offset);
+
+// jumps, branches and c.ebreak end a basic block
+bool is_control_transfer(Op op);
+
+// commands with a pc-relative target at pc + imm
+bool has_target(const DecodedInsn& insn);
+
+const char* get_op_name(Op op);
+
+std::string get_reg(std::uint32_t id);
+
+// mask/match pairs of every supported command; decode() has the final word on overlapping encodings
+const std::vector<Pattern>& get_patterns();
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HW3_DRIVER_H
+#define HW3_DRIVER_H
+
+#include "options.h"
+#include <string>
+
+namespace Parser {
+
+// disassembles one input file into one output file according to options
+void run(const std::string& input_file_name, const std::string& output_file_name, const Options& options);
+
+// runs the decoder over the words of options.sweep_range without an input file
+void run_sweep(const std::string& output_file_name, const Options& options);
+
+}
+
+#endif
@@ -3,6 +3,11 @@
 
 #include <cstdint>
 #include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+#include "options.h"
+#include "decoder.h"
 
 namespace Parser {
 
@@ -47,13 +52,158 @@ typedef struct {
     std::uint16_t st_shndx;
 } Elf32_Sym;
 
+typedef struct {
+    std::uint32_t r_offset;
+    std::uint32_t r_info;  // symbol index << 8 | type
+    std::int32_t r_addend;
+} Elf32_Rela;
+
+// header in front of the data of a SHF_COMPRESSED section
+typedef struct {
+    std::uint32_t ch_type;
+    std::uint32_t ch_size;
+    std::uint32_t ch_addralign;
+} Elf32_Chdr;
+
+typedef struct {
+    std::uint32_t p_type;
+    std::uint32_t p_offset;
+    std::uint32_t p_vaddr;
+    std::uint32_t p_paddr;
+    std::uint32_t p_filesz;
+    std::uint32_t p_memsz;
+    std::uint32_t p_flags;
+    std::uint32_t p_align;
+} Elf32_program_header;
+
 #pragma pack(pop)
 
 const int TEXT_TYPE = 1;
 const int SYMTAB_TYPE = 2;
 const int STRTAB_TYPE = 3;
+const int RELA_TYPE = 4;
+const int SYMTAB_SHNDX_TYPE = 18;
+
+// st_shndx values from here on are reserved (ABS, COMMON, ...) rather than section indexes
+const std::uint16_t SHN_LORESERVE = 0xff00;
+// st_shndx of a symbol whose section index is in the SHT_SYMTAB_SHNDX section
+const std::uint16_t SHN_XINDEX = 0xffff;
+// section of a symbol with a reserved st_shndx; never a real section index
+const std::uint32_t NO_SECTION = 0xffffffff;
+
+const std::uint32_t SHF_EXECINSTR = 0x4;
+const std::uint32_t SHF_COMPRESSED = 0x800;
+
+const std::uint32_t ELFCOMPRESS_ZLIB = 1;
+const std::uint32_t ELFCOMPRESS_ZSTD = 2;
+
+const int STT_FUNC = 2;
+
+const int STB_GLOBAL = 1;
+const int STB_WEAK = 2;
+
+const std::uint32_t PT_LOAD = 1;
+
+const std::uint16_t ET_REL = 1;
+const std::uint16_t ET_EXEC = 2;
+
+// relocations that set the target of a branch, jump or auipc+jalr call
+const std::uint32_t R_RISCV_BRANCH = 16;
+const std::uint32_t R_RISCV_JAL = 17;
+const std::uint32_t R_RISCV_CALL = 18;
+const std::uint32_t R_RISCV_CALL_PLT = 19;
+const std::uint32_t R_RISCV_RVC_BRANCH = 44;
+const std::uint32_t R_RISCV_RVC_JUMP = 45;
+
+ELF32_header read_file_header(std::istream& in);
+
+// all section headers; with extended numbering (e_shnum == 0) the count is sh_size of section 0
+std::vector<Elf32_section_header> read_section_headers(std::istream& in);
+
+std::vector<Elf32_program_header> read_program_headers(std::istream& in);
+
+std::uint32_t find_section(const std::vector<Elf32_section_header>& section_headers, int section_type_id);
+
+// section contents, decompressed when the section is SHF_COMPRESSED
+std::vector<char> read_section(std::istream& in, const Elf32_section_header& s_header);
+
+// contents of several sections; compressed ones are read one by one and decompressed on `jobs` threads
+std::vector<std::vector<char>> read_sections(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& s_headers,
+        unsigned jobs
+);
+
+// SHT_SYMTAB_SHNDX data linked to symbol table `symtab_id`, empty when the file has none
+std::vector<char> read_symtab_shndx(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& section_headers,
+        std::uint32_t symtab_id
+);
+
+// section index of symbol `id` of a symbol table, taken from `shndx` when st_shndx is SHN_XINDEX;
+// NO_SECTION for other reserved values, which files with many sections use as real indexes
+std::uint32_t get_symbol_section(const Elf32_Sym& sym, std::size_t id, const std::vector<char>& shndx);
+
+std::map<std::uint32_t, std::string> calc_tags(std::istream& in, std::vector<Elf32_section_header>& section_headers);
+
+// Formatted text of commands whose text does not depend on their address, direct-mapped by the
+// command bits, so that a repeated encoding is formatted once.
+struct FormatCache {
+    static const std::size_t SIZE = 4096;
+
+    struct Entry {
+        bool valid = false;
+        std::uint32_t raw = 0;
+        std::string text;
+    };
+
+    std::vector<Entry> entries = std::vector<Entry>(SIZE);
+    std::uint64_t lookups = 0;
+    std::uint64_t hits = 0;
+};
+
+// Output offsets of every step-th printed command and of every tagged command, taken from the
+// output stream while the listing is written.
+struct LineIndex {
+    std::uint32_t step = 1024;
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> entries;  // address, offset
+};
+
+// disassembles bytes [begin, end) of the .text contents `text`, both must be command boundaries; with
+// collapse_repeats runs of identical commands without tags inside print once plus a "... repeated N times" line
+void parse_text(
+        const std::vector<char>& text,
+        std::ostream& out,
+        const std::map<std::uint32_t, std::string>& tags,
+        std::uint32_t begin,
+        std::uint32_t end,
+        bool collapse_repeats = false,
+        FormatCache* cache = nullptr,
+        LineIndex* line_index = nullptr
+);
+
+// command text without the address column, e.g. "addi sp, sp, -16\n"
+std::string format_insn(const DecodedInsn& insn, std::uint32_t adr, const std::map<std::uint32_t, std::string>& tags);
+
+// prints the listing line of a command at .text offset adr
+void print_insn(
+        std::ostream& out,
+        std::uint32_t adr,
+        const std::string& tag,
+        const DecodedInsn& insn,
+        const std::map<std::uint32_t, std::string>& tags
+);
+
+// prints the symbol tables in table order, or sorted and filtered as options.sym_* ask
+void parse_symtab(
+        std::istream& in,
+        std::ostream& out,
+        std::vector<Elf32_section_header>& section_headers,
+        const Options& options = Options()
+);
 
-void parse(std::ifstream& in, std::ofstream& out);
+void parse(std::istream& in, std::ostream& out, const Options& options = Options(), FormatCache* cache = nullptr);
 
 }
 
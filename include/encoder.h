@@ -0,0 +1,19 @@
+#ifndef HW3_ENCODER_H
+#define HW3_ENCODER_H
+
+#include "decoder.h"
+#include <iosfwd>
+
+namespace Parser {
+
+// Command bits of a decoded command, the inverse of decode() for every supported command.
+// Bits decode() ignores come out as zero; Op::UNKNOWN keeps its raw bits.
+std::uint32_t encode(const DecodedInsn& insn);
+
+// Decodes every command of every executable section, sections in parallel on `jobs` threads,
+// encodes it back and prints the commands whose bits differ, followed by the totals.
+void verify_encoding(std::istream& in, std::ostream& out, unsigned jobs);
+
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef HW3_FUNCTION_FILTER_H
+#define HW3_FUNCTION_FILTER_H
+
+#include "options.h"
+#include <iosfwd>
+#include <string>
+
+namespace Parser {
+
+// shell-style match of the whole name: '*' is any run, '?' any character, "[a-z]" and "[!abc]" sets
+bool match_glob(const std::string& pattern, const std::string& name);
+
+// Disassembles only the functions whose names match options.functions, a glob or, with
+// options.functions_regex, an ECMAScript regex. Functions are decoded in parallel on options.jobs
+// threads and printed in address order.
+void disassemble_functions(std::istream& in, std::ostream& out, const Options& options);
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef HW3_INSTRUCTION_INDEX_H
+#define HW3_INSTRUCTION_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Parser {
+
+// Bitvector with one bit per halfword of a code section, set where an instruction starts,
+// plus a rank/select directory for constant-time offset <-> ordinal translation.
+class InstructionIndex {
+public:
+    InstructionIndex() = default;
+    explicit InstructionIndex(const std::vector<char>& code);
+
+    // number of instructions in the section
+    std::uint32_t size() const { return count; }
+
+    // ordinal of the instruction containing byte offset `offset`
+    std::uint32_t rank(std::uint32_t offset) const;
+
+    // byte offset of the instruction with ordinal `ordinal`
+    std::uint32_t select(std::uint32_t ordinal) const;
+
+    bool is_start(std::uint32_t offset) const;
+
+    const std::vector<std::uint64_t>& get_bits() const { return bits; }
+
+private:
+    static const std::uint32_t WORDS_PER_BLOCK = 8;
+    static const std::uint32_t SELECT_SAMPLE = 512;
+
+    std::uint32_t ones_before(std::uint32_t halfword) const;
+
+    std::vector<std::uint64_t> bits;
+    std::vector<std::uint32_t> block_rank;   // ones before each block of WORDS_PER_BLOCK words
+    std::vector<std::uint32_t> select_hint;  // word holding every SELECT_SAMPLE-th one
+    std::uint32_t count = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef HW3_OPTIONS_H
+#define HW3_OPTIONS_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+// half-open range of .text to disassemble, either in byte offsets or in instruction ordinals
+struct TextRange {
+    bool by_ordinal = false;
+    std::uint32_t begin = 0;
+    std::uint32_t end = std::numeric_limits<std::uint32_t>::max();
+
+    bool is_full() const { return begin == 0 && end == std::numeric_limits<std::uint32_t>::max(); }
+};
+
+enum class WorkerProtocol {
+    NONE,
+    LINES,
+    LENGTH
+};
+
+enum class Compression {
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+enum class TraceFormat {
+    TEXT,
+    BINARY
+};
+
+enum class SizeReport {
+    NONE,
+    TABLE,
+    JSON
+};
+
+enum class CallGraphFormat {
+    NONE,
+    DOT,
+    JSON
+};
+
+enum class SymbolSort {
+    NONE,
+    ADDRESS,
+    SIZE,
+    NAME
+};
+
+struct Options {
+    TextRange range;
+    bool watch = false;
+    WorkerProtocol worker = WorkerProtocol::NONE;
+    unsigned jobs = 1;
+    Compression compression = Compression::NONE;
+    std::string search;
+    bool simulate = false;
+    std::string simulate_entry;
+    std::uint64_t max_steps = 100000000;
+    std::string trace;
+    TraceFormat trace_format = TraceFormat::TEXT;
+    std::string samples;
+    std::vector<std::string> coverage;
+    SizeReport size_report = SizeReport::NONE;
+    bool rvc_report = false;
+    bool stack_report = false;
+    CallGraphFormat call_graph = CallGraphFormat::NONE;
+    bool unreferenced = false;
+    bool verify = false;
+    bool sweep = false;
+    TextRange sweep_range;  // words to decode, an open end includes 0xffffffff
+    bool sweep_format = false;
+    bool collapse_repeats = false;
+    bool stats = false;
+    std::string line_index;
+    std::uint32_t line_index_step = 1024;
+    // parts of the listing to print
+    bool print_text = true;
+    bool print_symtab = true;
+    std::string functions;
+    bool functions_regex = false;
+    // symbol table order and filters, empty filters take every symbol
+    SymbolSort sym_sort = SymbolSort::NONE;
+    std::string sym_type;
+    std::string sym_bind;
+    std::string sym_section;
+};
+
+Options parse_options(const std::vector<std::string>& args);
+
+Options parse_options(int argc, char * argv[], int first);
+
+// false when options ask for a report, an analysis or a function filter instead of the listing
+bool is_listing(const Options& options);
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HW3_PARALLEL_H
+#define HW3_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parser {
+
+// Calls body(i) for every i in [0, count) on up to `jobs` threads. Threads take the next index from
+// a shared counter, so uneven items balance out. The first exception thrown by body is rethrown.
+template <typename Body>
+void parallel_for(std::size_t count, unsigned jobs, const Body& body) {
+    std::size_t threads_count = std::min<std::size_t>(std::max(jobs, 1u), count);
+    if (threads_count <= 1) {
+        for (std::size_t i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run = [&] {
+        try {
+            for (std::size_t i = next++; i < count; i = next++) {
+                body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < threads_count; t++) {
+        threads.emplace_back(run);
+    }
+    run();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Sorts items with `less` on up to `jobs` threads: equal slices are sorted in parallel, then merged
+// pairwise in rounds, every round merging its pairs in parallel.
+template <typename T, typename Less>
+void parallel_sort(std::vector<T>& items, unsigned jobs, const Less& less) {
+    std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(std::max(jobs, 1u), items.size() / 1024));
+    std::vector<std::size_t> bounds(parts + 1);
+    for (std::size_t k = 0; k <= parts; k++) {
+        bounds[k] = items.size() * k / parts;
+    }
+    parallel_for(parts, jobs, [&](std::size_t k) {
+        std::sort(items.begin() + bounds[k], items.begin() + bounds[k + 1], less);
+    });
+    for (std::size_t width = 1; width < parts; width *= 2) {
+        parallel_for((parts + 2 * width - 1) / (2 * width), jobs, [&](std::size_t pair) {
+            auto first = pair * 2 * width;
+            auto middle = std::min(first + width, parts), last = std::min(first + 2 * width, parts);
+            std::inplace_merge(items.begin() + bounds[first], items.begin() + bounds[middle],
+                               items.begin() + bounds[last], less);
+        });
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HW3_PROFILE_H
+#define HW3_PROFILE_H
+
+#include "options.h"
+#include <iosfwd>
+#include <string>
+
+namespace Parser {
+
+// Counts PC samples per command and prints the functions with samples, hottest first, each with its
+// share of all samples and its commands annotated with their share of the function's samples.
+void annotate_samples(std::istream& in, std::ostream& out, const std::string& samples_file_name, TraceFormat format);
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HW3_RVC_REPORT_H
+#define HW3_RVC_REPORT_H
+
+#include "decoder.h"
+#include <iosfwd>
+
+namespace Parser {
+
+// compressed command with the same effect as the 32-bit `insn` under its current operands
+// (RV32C register, immediate and rd == rs1 constraints), Op::UNKNOWN when there is none
+Op get_compressed_op(const DecodedInsn& insn);
+
+// For every function prints how many of its 32-bit commands have an RVC equivalent and the bytes
+// compressing them would save, then the same per mnemonic. Functions are scanned on `jobs` threads.
+void report_rvc(std::istream& in, std::ostream& out, unsigned jobs);
+
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef HW3_SEARCH_H
+#define HW3_SEARCH_H
+
+#include "decoder.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+struct SearchPattern {
+    std::uint32_t mask;
+    std::uint32_t match;
+    bool check_op;      // the query named a command, so the decoded op must agree
+    Op op;
+};
+
+// Compiles a comma-separated list of command names ("div,c.jal") and hexadecimal MASK/MATCH pairs
+// ("0xfff0707f/0x30001073") into patterns.
+std::vector<SearchPattern> compile_query(const std::string& query);
+
+// Prints address, containing function and disassembly of every command in executable sections
+// matching the query. Only the candidates selected by mask/match are decoded.
+void search(std::istream& in, std::ostream& out, const std::string& query);
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef HW3_SIMULATOR_H
+#define HW3_SIMULATOR_H
+
+#include "decoder.h"
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Parser {
+
+// Sparse little-endian memory split into 4 KiB pages allocated on first write.
+class Memory {
+public:
+    std::uint8_t load8(std::uint32_t adr);
+    std::uint16_t load16(std::uint32_t adr);
+    std::uint32_t load32(std::uint32_t adr);
+    void store8(std::uint32_t adr, std::uint8_t value);
+    void store16(std::uint32_t adr, std::uint16_t value);
+    void store32(std::uint32_t adr, std::uint32_t value);
+    void store(std::uint32_t adr, const char* data, std::size_t size);
+    bool is_mapped(std::uint32_t adr) { return get_page(adr, false) != nullptr; }
+
+private:
+    static const std::uint32_t PAGE_BITS = 12;
+    static const std::uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+    typedef std::array<std::uint8_t, PAGE_SIZE> Page;
+
+    Page* get_page(std::uint32_t adr, bool allocate);
+
+    std::unordered_map<std::uint32_t, std::unique_ptr<Page>> pages;
+    std::uint32_t last_page_id = 0;
+    Page* last_page = nullptr;
+};
+
+// Straight-line run of predecoded commands, ended by the first control transfer. A fetch from
+// unmapped memory ends it with an UNKNOWN command of length 0.
+struct Block {
+    std::vector<DecodedInsn> insns;
+};
+
+// RV32IMC interpreter over the commands decode() knows. Blocks are decoded once and cached by PC.
+class Simulator {
+public:
+    // returning to this address from the entry function ends the simulation
+    static const std::uint32_t RETURN_ADDRESS = 0xfffffff0;
+    static const std::uint32_t STACK_TOP = 0xffff0000;
+
+    explicit Simulator(Memory memory);
+
+    // runs from pc until the entry returns, ebreak, an unsupported command or max_steps commands
+    void run(std::uint32_t entry, std::uint64_t max_steps);
+
+    std::uint32_t get_reg_value(std::uint32_t id) const { return x[id]; }
+    std::uint32_t get_pc() const { return pc; }
+    std::uint64_t get_steps() const { return steps; }
+    std::size_t get_blocks_count() const { return blocks.size(); }
+    std::uint64_t get_decoded_count() const { return decoded; }
+    const std::string& get_stop_reason() const { return stop_reason; }
+
+private:
+    static const std::size_t MAX_BLOCK_LENGTH = 64;
+
+    const Block& get_block(std::uint32_t adr);
+
+    // executes one block, returns false when the simulation has to stop
+    bool run_block(const Block& block);
+
+    void store_invalidate(std::uint32_t adr);
+
+    Memory memory;
+    std::uint32_t x[32] = {};
+    std::uint32_t pc = 0;
+    std::uint64_t steps = 0;
+    std::uint64_t decoded = 0;
+    std::string stop_reason;
+    std::unordered_map<std::uint32_t, Block> blocks;
+    std::uint32_t code_begin = 0xffffffff;
+    std::uint32_t code_end = 0;
+};
+
+// loads PT_LOAD segments (or .text of a relocatable file) and simulates from `entry`, which is a
+// symbol name, an address or empty for e_entry, then prints the final state and the speed
+void simulate(std::istream& in, std::ostream& out, const std::string& entry, std::uint64_t max_steps);
+
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HW3_SIZE_REPORT_H
+#define HW3_SIZE_REPORT_H
+
+#include "options.h"
+#include <iosfwd>
+
+namespace Parser {
+
+// Attributes every byte of the executable sections to a function or to an "unattributed" gap and
+// prints size, command count, share of compressed commands and most frequent mnemonics of each,
+// largest first, as a table or as a JSON array. Ranges are decoded in parallel on `jobs` threads.
+void report_sizes(std::istream& in, std::ostream& out, SizeReport format, unsigned jobs);
+
+}
+
+#endif
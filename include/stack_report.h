@@ -0,0 +1,15 @@
+#ifndef HW3_STACK_REPORT_H
+#define HW3_STACK_REPORT_H
+
+#include <iosfwd>
+
+namespace Parser {
+
+// Reads the frame size and the spilled registers from every function's prologue and prints them,
+// then the worst-case stack depth of every entry point (e_entry and functions nobody calls) over
+// the direct call graph. Recursion and indirect calls make the depth a lower bound and are marked.
+void report_stack(std::istream& in, std::ostream& out);
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HW3_SWEEP_H
+#define HW3_SWEEP_H
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace Parser {
+
+// Decodes every word of [begin, end) on `jobs` threads, which take chunks of the range as they
+// finish the previous ones, and prints valid, unknown and failed words per major opcode, counts per
+// mnemonic and the decoding speed. With `format` every word is also printed to a string, and
+// exceptions thrown there are counted and the first one of every opcode is shown.
+void sweep(std::ostream& out, std::uint64_t begin, std::uint64_t end, bool format, unsigned jobs);
+
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef HW3_SYMBOLS_H
+#define HW3_SYMBOLS_H
+
+#include "elf_parser.h"
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+struct Function {
+    std::string name;
+    std::uint32_t address;
+    std::uint32_t size;
+    std::uint32_t section;
+    std::uint8_t bind;
+};
+
+// STT_FUNC symbols of all symbol tables, sorted by address
+std::vector<Function> collect_functions(std::istream& in, const std::vector<Elf32_section_header>& section_headers);
+
+// function whose range holds address; functions without a size extend to the next function
+const Function* find_function(const std::vector<Function>& functions, std::uint32_t address);
+
+// "name+0x1c" for an address inside a function, "?" otherwise
+std::string get_location(const std::vector<Function>& functions, std::uint32_t address);
+
+}
+
+#endif
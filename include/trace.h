@@ -0,0 +1,36 @@
+#ifndef HW3_TRACE_H
+#define HW3_TRACE_H
+
+#include "options.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Parser {
+
+// Streams the PCs of a trace file: hexadecimal numbers one per line ('#' starts a comment)
+// or little-endian 32-bit words.
+class TraceReader {
+public:
+    TraceReader(const std::string& file_name, TraceFormat format);
+
+    // returns false at the end of the trace
+    bool next(std::uint32_t& pc);
+
+private:
+    bool fill();
+
+    std::ifstream in;
+    TraceFormat format;
+    std::vector<char> buffer;
+    std::size_t position = 0;
+    std::size_t size = 0;
+};
+
+// prints every PC of the trace with its function and disassembly, decoding each distinct PC once
+void annotate_trace(std::istream& in, std::ostream& out, const std::string& trace_file_name, TraceFormat format);
+
+}
+
+#endif
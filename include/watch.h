@@ -0,0 +1,15 @@
+#ifndef HW3_WATCH_H
+#define HW3_WATCH_H
+
+#include "options.h"
+#include <string>
+
+namespace Parser {
+
+// disassembles input_file_name into output_file_name, then keeps doing so every time the input changes,
+// re-disassembling only the functions whose bytes changed. Never returns normally.
+void watch(const std::string& input_file_name, const std::string& output_file_name, const Options& options);
+
+}
+
+#endif
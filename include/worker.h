@@ -0,0 +1,17 @@
+#ifndef HW3_WORKER_H
+#define HW3_WORKER_H
+
+#include "options.h"
+#include <iosfwd>
+
+namespace Parser {
+
+// Serves disassembly requests until `requests` ends. Every request is "<input> <output> [options...]",
+// either one per line (arguments separated by whitespace) or as a 4-byte little-endian length followed
+// by the arguments separated by '\0'. Every request gets an "OK" or "ERROR <message>" response framed
+// the same way, in request order, even when options.jobs requests are processed concurrently.
+void run_worker(std::istream& requests, std::ostream& responses, const Options& options);
+
+}
+
+#endif
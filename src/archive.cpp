@@ -0,0 +1,184 @@
+#include "archive.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Parser {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& file_name) {
+    std::ifstream in(file_name, std::ios::binary);
+    if (!in) {
+        throw std::invalid_argument("can't open " + file_name);
+    }
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    begin = contents.data();
+    length = contents.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+MappedFile::MappedFile(const std::string& file_name) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::invalid_argument("can't open " + file_name);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::invalid_argument("can't stat " + file_name);
+    }
+    length = info.st_size;
+    if (length != 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            close(fd);
+            throw std::invalid_argument("can't map " + file_name);
+        }
+        begin = static_cast<const char*>(address);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (begin != nullptr) {
+        munmap(const_cast<char*>(begin), length);
+    }
+}
+
+#endif
+
+MemoryBuffer::MemoryBuffer(const char* data, std::size_t size) {
+    auto begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+    return seekpos(pos_type(base + offset), which);
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekpos(pos_type position, std::ios_base::openmode which) {
+    off_type offset = position;
+    if (!(which & std::ios_base::in) || offset < 0 || offset > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + offset, egptr());
+    return position;
+}
+
+bool is_archive(std::istream& in) {
+    char magic[ARCHIVE_MAGIC_SIZE];
+    in.seekg(0);
+    in.read(magic, sizeof(magic));
+    return std::memcmp(magic, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) == 0;
+}
+
+#pragma pack(push, 1)
+
+typedef struct {
+    char ar_name[16];
+    char ar_date[12];
+    char ar_uid[6];
+    char ar_gid[6];
+    char ar_mode[8];
+    char ar_size[10];
+    char ar_fmag[2];
+} Ar_header;
+
+#pragma pack(pop)
+
+// fields are space padded decimal numbers
+static std::size_t get_number(const char* field, std::size_t size) {
+    std::string text(field, size);
+    char* end;
+    auto number = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        throw std::invalid_argument("bad number in archive member header");
+    }
+    return number;
+}
+
+static std::string trim(const char* field, std::size_t size) {
+    while (size > 0 && field[size - 1] == ' ') {
+        size--;
+    }
+    return std::string(field, size);
+}
+
+std::vector<ArchiveMember> read_archive_members(const char* data, std::size_t size) {
+    if (size < ARCHIVE_MAGIC_SIZE || std::memcmp(data, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) != 0) {
+        throw std::invalid_argument("this is not an ar archive");
+    }
+    std::vector<ArchiveMember> members;
+    const char* long_names = nullptr;
+    std::size_t long_names_size = 0;
+    std::size_t offset = ARCHIVE_MAGIC_SIZE;
+    while (offset + sizeof(Ar_header) <= size) {
+        Ar_header header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.ar_fmag[0] != '`' || header.ar_fmag[1] != '\n') {
+            throw std::invalid_argument("bad archive member header");
+        }
+        ArchiveMember member{trim(header.ar_name, sizeof(header.ar_name)), offset + sizeof(header),
+                             get_number(header.ar_size, sizeof(header.ar_size))};
+        if (member.size > size - member.offset) {
+            throw std::invalid_argument("archive member is outside of the file");
+        }
+        // data is aligned to 2 bytes
+        offset = member.offset + member.size + member.size % 2;
+
+        auto raw_name = member.name;
+        if (member.name == "//") {
+            long_names = data + member.offset;
+            long_names_size = member.size;
+            continue;
+        }
+        if (member.name.size() > 1 && member.name[0] == '/' && member.name != "/SYM64/") {
+            // GNU: offset into the long-name table, where names end with "/\n"
+            auto name_offset = get_number(member.name.c_str() + 1, member.name.size() - 1);
+            if (name_offset >= long_names_size) {
+                throw std::invalid_argument("archive member name is outside of the long-name table");
+            }
+            auto name = long_names + name_offset;
+            auto end = static_cast<const char*>(std::memchr(name, '\n', long_names_size - name_offset));
+            std::size_t length = (end == nullptr ? long_names + long_names_size : end) - name;
+            if (length > 0 && name[length - 1] == '/') {
+                length--;
+            }
+            member.name.assign(name, length);
+        } else if (member.name.compare(0, 3, "#1/") == 0) {
+            // BSD: the name takes the first N bytes of the data
+            auto length = get_number(member.name.c_str() + 3, member.name.size() - 3);
+            if (length > member.size) {
+                throw std::invalid_argument("archive member name is longer than the member");
+            }
+            member.name = std::string(data + member.offset, strnlen(data + member.offset, length));
+            member.offset += length;
+            member.size -= length;
+        } else if (!member.name.empty() && member.name.back() == '/') {
+            member.name.pop_back();
+        }
+        // symbol indexes; llvm-ar --format=bsd names __.SYMDEF through "#1/N", so check resolved names
+        if (raw_name == "/" || raw_name == "/SYM64/" || member.name == "__.SYMDEF" ||
+                member.name == "__.SYMDEF SORTED") {
+            continue;
+        }
+        members.push_back(member);
+    }
+    return members;
+}
+
+}
@@ -0,0 +1,156 @@
+#include "call_graph.h"
+#include "parallel.h"
+#include <algorithm>
+#include <map>
+#include <ostream>
+
+namespace Parser {
+
+FunctionCode get_function_code(const std::vector<Function>& functions, std::size_t i,
+                               const std::vector<CodeSection>& code) {
+    FunctionCode result;
+    auto section = find_function_code(code, functions[i]);
+    if (section == nullptr) {
+        return result;
+    }
+    auto end = get_function_end(functions, i, *section);
+    const auto& index = section->index;
+    result.section = section;
+    result.first = result.last = index.rank(functions[i].address - section->address);
+    while (result.last < index.size() && section->address + index.select(result.last) < end) {
+        result.last++;
+    }
+    return result;
+}
+
+std::size_t find_function_index(const std::vector<Function>& functions, std::uint32_t address) {
+    auto function = find_function(functions, address);
+    return function == nullptr ? functions.size() : function - functions.data();
+}
+
+// a jump without link counts only if it leaves the caller, otherwise it is a branch inside it
+FunctionLookup::FunctionLookup(const std::vector<Function>& functions) : functions(functions) {
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        by_section.push_back(i);
+    }
+    // functions are sorted by address already, so a stable sort by section keeps that order inside
+    std::stable_sort(by_section.begin(), by_section.end(), [&](std::size_t a, std::size_t b) {
+        return functions[a].section < functions[b].section;
+    });
+}
+
+std::size_t FunctionLookup::find(std::uint32_t address, const CodeSection& section) const {
+    return section.relocatable ? find_in_section(section.id, address) : find_function_index(functions, address);
+}
+
+std::size_t FunctionLookup::find_target(const CodeSection& section, std::uint32_t offset, std::uint32_t target) const {
+    auto jump = section.jumps.find(offset);
+    if (jump == section.jumps.end()) {
+        return find(target, section);
+    }
+    return jump->second.section == 0 ? functions.size() : find_in_section(jump->second.section, jump->second.address);
+}
+
+std::size_t FunctionLookup::find_in_section(std::uint32_t section, std::uint32_t address) const {
+    auto it = std::upper_bound(by_section.begin(), by_section.end(), std::make_pair(section, address),
+                               [&](const std::pair<std::uint32_t, std::uint32_t>& key, std::size_t i) {
+        return key < std::make_pair(functions[i].section, functions[i].address);
+    });
+    if (it == by_section.begin() || functions[*(it - 1)].section != section) {
+        return functions.size();
+    }
+    const auto& function = functions[*(it - 1)];
+    if (function.size != 0 && address - function.address >= function.size) {
+        return functions.size();
+    }
+    return *(it - 1);
+}
+
+static void add_call(const std::vector<Function>& functions, const FunctionLookup& lookup,
+                     const CodeSection& section, std::size_t caller, std::vector<CallSite>& calls,
+                     std::uint32_t offset, std::uint32_t target, bool tail) {
+    auto callee = lookup.find_target(section, offset, target);
+    if (callee != functions.size() && !(tail && callee == caller)) {
+        calls.push_back({section.address + offset, callee, tail});
+    }
+}
+
+CallGraph build_call_graph(const std::vector<Function>& functions, const std::vector<CodeSection>& code,
+                           unsigned jobs) {
+    CallGraph graph;
+    graph.calls.resize(functions.size());
+    graph.indirect.assign(functions.size(), false);
+    FunctionLookup lookup(functions);
+    parallel_for(functions.size(), jobs, [&](std::size_t i) {
+        auto function_code = get_function_code(functions, i, code);
+        // register written by the previous command if it was auipc, and the address it holds
+        std::uint32_t auipc_reg = 0, auipc_value = 0;
+        for (auto ordinal = function_code.first; ordinal < function_code.last; ordinal++) {
+            auto offset = function_code.section->index.select(ordinal);
+            std::uint32_t adr = function_code.section->address + offset;
+            auto insn = decode(get_word(function_code.section->data, offset));
+            if (insn.op == Op::C_JAL || insn.op == Op::C_J || insn.op == Op::JAL) {
+                bool tail = (insn.op == Op::C_J || (insn.op == Op::JAL && insn.rd == 0));
+                add_call(functions, lookup, *function_code.section, i, graph.calls[i], offset, adr + insn.imm, tail);
+            } else if (insn.op == Op::JALR && auipc_reg != 0 && insn.rs1 == auipc_reg) {
+                add_call(functions, lookup, *function_code.section, i, graph.calls[i], offset - 4,
+                         auipc_value + insn.imm, insn.rd == 0);
+            } else if (insn.op == Op::C_JALR || (insn.op == Op::JALR && insn.rd != 0) ||
+                       ((insn.op == Op::JALR || insn.op == Op::C_JR) && insn.rs1 != 1)) {
+                // a jump through anything but ra is a jump table or an indirect tail call, not a return
+                graph.indirect[i] = true;
+            }
+            auipc_reg = (insn.op == Op::AUIPC ? insn.rd : 0);
+            auipc_value = adr + insn.imm;
+        }
+    });
+    return graph;
+}
+
+void export_call_graph(std::istream& in, std::ostream& out, CallGraphFormat format, unsigned jobs) {
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, jobs);
+    auto graph = build_call_graph(functions, code, jobs);
+
+    // call sites per callee of every caller
+    std::vector<std::map<std::size_t, std::uint32_t>> edges(functions.size());
+    parallel_for(functions.size(), jobs, [&](std::size_t i) {
+        for (const auto& call : graph.calls[i]) {
+            edges[i][call.callee]++;
+        }
+    });
+
+    if (format == CallGraphFormat::DOT) {
+        out << "digraph calls {\n";
+        for (std::size_t i = 0; i < functions.size(); i++) {
+            out << "    \"" << escape_dot(functions[i].name) << "\"" << (graph.indirect[i] ? " [style=dashed]" : "")
+                << ";\n";
+        }
+        for (std::size_t i = 0; i < functions.size(); i++) {
+            for (const auto& edge : edges[i]) {
+                out << "    \"" << escape_dot(functions[i].name) << "\" -> \"" << escape_dot(functions[edge.first].name)
+                    << "\" [label=" << edge.second << "];\n";
+            }
+        }
+        out << "}\n";
+        return;
+    }
+    out << "{\"functions\": [";
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"" << escape_json(functions[i].name) << "\", \"address\": "
+            << functions[i].address << ", \"indirect_calls\": " << (graph.indirect[i] ? "true" : "false") << "}";
+    }
+    out << "\n], \"edges\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        for (const auto& edge : edges[i]) {
+            out << (first ? "\n" : ",\n") << "  {\"caller\": " << i << ", \"callee\": " << edge.first
+                << ", \"calls\": " << edge.second << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+}
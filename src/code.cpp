@@ -0,0 +1,145 @@
+#include "code.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Parser {
+
+static bool is_jump_relocation(std::uint32_t type) {
+    return type == R_RISCV_BRANCH || type == R_RISCV_JAL || type == R_RISCV_CALL || type == R_RISCV_CALL_PLT ||
+           type == R_RISCV_RVC_BRANCH || type == R_RISCV_RVC_JUMP;
+}
+
+static void load_jumps(std::istream& in, const std::vector<Elf32_section_header>& section_headers,
+                       std::vector<CodeSection>& code) {
+    for (const auto& s_header : section_headers) {
+        if (s_header.sh_type != RELA_TYPE || s_header.sh_link >= section_headers.size()) {
+            continue;
+        }
+        auto section = std::find_if(code.begin(), code.end(), [&](const CodeSection& c) {
+            return c.id == s_header.sh_info;
+        });
+        if (section == code.end()) {
+            continue;
+        }
+        auto relocations = read_section(in, s_header);
+        auto symbols = read_section(in, section_headers[s_header.sh_link]);
+        auto shndx = read_symtab_shndx(in, section_headers, s_header.sh_link);
+        for (std::size_t i = 0; i + sizeof(Elf32_Rela) <= relocations.size(); i += sizeof(Elf32_Rela)) {
+            Elf32_Rela rela;
+            std::memcpy(&rela, relocations.data() + i, sizeof(rela));
+            std::size_t id = rela.r_info >> 8;
+            if (!is_jump_relocation(rela.r_info & 0xff) || (id + 1) * sizeof(Elf32_Sym) > symbols.size()) {
+                continue;
+            }
+            Elf32_Sym sym;
+            std::memcpy(&sym, symbols.data() + id * sizeof(sym), sizeof(sym));
+            section->jumps[rela.r_offset] = {get_symbol_section(sym, id, shndx), sym.st_value + rela.r_addend};
+        }
+    }
+}
+
+std::vector<CodeSection> load_code(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& section_headers,
+        unsigned jobs
+) {
+    std::vector<std::uint32_t> ids;
+    std::vector<Elf32_section_header> headers;
+    for (std::size_t i = 0; i < section_headers.size(); i++) {
+        const auto& s_header = section_headers[i];
+        if (s_header.sh_type == TEXT_TYPE && (s_header.sh_flags & SHF_EXECINSTR)) {
+            ids.push_back(i);
+            headers.push_back(s_header);
+        }
+    }
+    bool relocatable = read_file_header(in).e_type == ET_REL;
+    auto data = read_sections(in, headers, jobs);
+    std::vector<CodeSection> code(ids.size());
+    parallel_for(code.size(), jobs, [&](std::size_t k) {
+        InstructionIndex index(data[k]);
+        code[k] = {ids[k], headers[k].sh_addr, std::move(data[k]), std::move(index), relocatable, {}};
+    });
+    if (relocatable) {
+        load_jumps(in, section_headers, code);
+    }
+    return code;
+}
+
+const CodeSection* find_code(const std::vector<CodeSection>& code, std::uint32_t adr) {
+    for (const auto& section : code) {
+        if (section.contains(adr)) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+const CodeSection* find_function_code(const std::vector<CodeSection>& code, const Function& function) {
+    for (const auto& section : code) {
+        if (section.id == function.section && section.contains(function.address)) {
+            return &section;
+        }
+    }
+    if (!code.empty() && code[0].relocatable) {
+        return nullptr;
+    }
+    return find_code(code, function.address);
+}
+
+std::uint32_t get_function_end(const std::vector<Function>& functions, std::size_t i, const CodeSection& section) {
+    std::uint32_t section_end = section.address + section.data.size();
+    if (functions[i].size != 0) {
+        return std::min(section_end, functions[i].address + functions[i].size);
+    }
+    for (auto j = i + 1; j < functions.size(); j++) {
+        if (functions[j].address > functions[i].address && functions[j].section == functions[i].section) {
+            return std::min(section_end, functions[j].address);
+        }
+    }
+    return section_end;
+}
+
+std::string describe_insn(const DecodedInsn& insn, std::uint32_t adr, const std::map<std::uint32_t, std::string>& tags) {
+    if (insn.op != Op::UNKNOWN) {
+        return format_insn(insn, adr, tags);
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "unknown_command 0x%0*x\n", insn.length * 2, insn.raw & (insn.length == 2 ? 0xffff : 0xffffffff));
+    return buf;
+}
+
+std::string escape_json(const std::string& s) {
+    std::string result;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            result += buf;
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::string escape_dot(const std::string& s) {
+    std::string result;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+}
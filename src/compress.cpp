@@ -0,0 +1,157 @@
+#include "compress.h"
+#include "parallel.h"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef HW3_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HW3_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Parser {
+
+#ifdef HW3_HAVE_ZLIB
+static std::string compress_gzip(const char* data, std::size_t size) {
+    z_stream stream{};
+    // 16 + MAX_WBITS asks zlib for a gzip header and trailer instead of a raw zlib stream
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::invalid_argument("can't initialize gzip compression");
+    }
+    std::string result(deflateBound(&stream, size), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = size;
+    stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+    stream.avail_out = result.size();
+    auto status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        throw std::invalid_argument("gzip compression failed");
+    }
+    result.resize(stream.total_out);
+    return result;
+}
+#endif
+
+#ifdef HW3_HAVE_ZSTD
+static std::string compress_zstd(const char* data, std::size_t size) {
+    std::string result(ZSTD_compressBound(size), '\0');
+    auto length = ZSTD_compress(&result[0], result.size(), data, size, 3);
+    if (ZSTD_isError(length)) {
+        throw std::invalid_argument(std::string("zstd compression failed: ") + ZSTD_getErrorName(length));
+    }
+    result.resize(length);
+    return result;
+}
+#endif
+
+static std::string compress_block(const char* data, std::size_t size, Compression compression) {
+    switch (compression) {
+#ifdef HW3_HAVE_ZLIB
+        case Compression::GZIP: return compress_gzip(data, size);
+#endif
+#ifdef HW3_HAVE_ZSTD
+        case Compression::ZSTD: return compress_zstd(data, size);
+#endif
+        case Compression::NONE: return std::string(data, size);
+        default: throw std::invalid_argument("hw3 was built without support for this compression");
+    }
+}
+
+// format limits on how far one compressed byte can expand: a deflate match copies at most 258 bytes
+// for about two bits, a 4 byte zstd RLE block repeats one byte up to 128 KiB
+const std::size_t MAX_ZLIB_RATIO = 1032;
+const std::size_t MAX_ZSTD_RATIO = 1 << 15;
+
+std::vector<char> decompress(const char* data, std::size_t data_size, std::size_t size, bool is_zstd) {
+    // size comes from the file, so check it before allocating
+    if (size / (is_zstd ? MAX_ZSTD_RATIO : MAX_ZLIB_RATIO) > data_size) {
+        throw std::invalid_argument("compressed data of " + std::to_string(data_size) + " bytes can't expand to " +
+                                    std::to_string(size) + " bytes");
+    }
+    std::vector<char> result(size);
+    if (is_zstd) {
+#ifdef HW3_HAVE_ZSTD
+        auto length = ZSTD_decompress(result.data(), size, data, data_size);
+        if (ZSTD_isError(length) || length != size) {
+            throw std::invalid_argument("broken zstd compressed data");
+        }
+        return result;
+#else
+        throw std::invalid_argument("hw3 was built without zstd support");
+#endif
+    }
+#ifdef HW3_HAVE_ZLIB
+    uLongf length = size;
+    if (uncompress(reinterpret_cast<Bytef *>(result.data()), &length, reinterpret_cast<const Bytef *>(data), data_size) != Z_OK ||
+            length != size) {
+        throw std::invalid_argument("broken zlib compressed data");
+    }
+    return result;
+#else
+    throw std::invalid_argument("hw3 was built without zlib support");
+#endif
+}
+
+void check_compression(Compression compression) {
+    compress_block("", 0, compression);
+}
+
+CompressingBuffer::CompressingBuffer(std::ostream& out, Compression compression, unsigned jobs)
+        : out(out), compression(compression), jobs(std::max(jobs, 1u)) {
+    start_block();
+}
+
+void CompressingBuffer::start_block() {
+    blocks.emplace_back(COMPRESSION_BLOCK_SIZE, '\0');
+    auto& block = blocks.back();
+    setp(&block[0], &block[0] + block.size());
+}
+
+void CompressingBuffer::write_blocks() {
+    parallel_for(blocks.size(), jobs, [&](std::size_t i) {
+        blocks[i] = compress_block(blocks[i].data(), blocks[i].size(), compression);
+    });
+    for (const auto& block : blocks) {
+        out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    blocks.clear();
+    written = true;
+}
+
+CompressingBuffer::int_type CompressingBuffer::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    before += COMPRESSION_BLOCK_SIZE;
+    if (blocks.size() == jobs) {
+        write_blocks();
+    }
+    start_block();
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+CompressingBuffer::pos_type CompressingBuffer::seekoff(off_type offset, std::ios_base::seekdir dir,
+                                                      std::ios_base::openmode which) {
+    if (offset != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+        return pos_type(off_type(-1));
+    }
+    return pos_type(off_type(before + (pptr() - pbase())));
+}
+
+void CompressingBuffer::finish() {
+    blocks.back().resize(pptr() - pbase());
+    // an empty output still gets one (empty) member
+    if (blocks.back().empty() && written) {
+        blocks.pop_back();
+    }
+    write_blocks();
+    setp(nullptr, nullptr);
+}
+
+}
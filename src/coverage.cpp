@@ -0,0 +1,163 @@
+#include "coverage.h"
+#include "code.h"
+#include "parallel.h"
+#include "trace.h"
+#include <cstdio>
+#include <mutex>
+
+namespace Parser {
+
+// one bit per command ordinal of every code section
+typedef std::vector<std::vector<std::uint64_t>> CoverageBits;
+
+static bool test_bit(const std::vector<std::uint64_t>& bits, std::uint32_t i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+static void set_bit(std::vector<std::uint64_t>& bits, std::uint32_t i) {
+    bits[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+static CoverageBits make_bits(const std::vector<CodeSection>& code) {
+    CoverageBits bits(code.size());
+    for (std::size_t i = 0; i < code.size(); i++) {
+        bits[i].assign((code[i].index.size() + 63) / 64, 0);
+    }
+    return bits;
+}
+
+static std::string format_range(std::uint32_t begin, std::uint32_t end) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), " %08x-%08x", begin, end);
+    return buf;
+}
+
+void report_coverage(std::istream& in, std::ostream& out, const std::vector<std::string>& trace_file_names,
+                     TraceFormat format, unsigned jobs) {
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, jobs);
+
+    auto executed = make_bits(code);
+    std::uint64_t total = 0, outside = 0;
+    std::mutex merge_mutex;
+    parallel_for(trace_file_names.size(), jobs, [&](std::size_t t) {
+        auto bits = make_bits(code);
+        std::uint64_t pcs = 0, missed = 0;
+        TraceReader trace(trace_file_names[t], format);
+        std::uint32_t pc;
+        while (trace.next(pc)) {
+            pcs++;
+            auto section = find_code(code, pc);
+            if (section == nullptr || pc - section->address >= section->data.size() / 2 * 2) {
+                missed++;
+                continue;
+            }
+            set_bit(bits[section - code.data()], section->index.rank(pc - section->address));
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        for (std::size_t i = 0; i < code.size(); i++) {
+            for (std::size_t w = 0; w < bits[i].size(); w++) {
+                executed[i][w] |= bits[i][w];
+            }
+        }
+        total += pcs;
+        outside += missed;
+    });
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%zu trace files, %llu PCs, %llu outside of code\n", trace_file_names.size(),
+             static_cast<unsigned long long>(total), static_cast<unsigned long long>(outside));
+    out << buf;
+
+    std::uint64_t all_commands = 0, all_executed = 0;
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        auto section = find_function_code(code, functions[i]);
+        if (section == nullptr) {
+            continue;
+        }
+        auto end = get_function_end(functions, i, *section);
+        const auto& index = section->index;
+        const auto& bits = executed[section - code.data()];
+        auto first = index.rank(functions[i].address - section->address);
+        auto last = first;
+        while (last < index.size() && section->address + index.select(last) < end) {
+            last++;
+        }
+
+        // basic blocks start at the function entry, after every control transfer and at every
+        // branch target inside the function
+        std::vector<bool> leaders(last - first, false);
+        std::uint32_t executed_count = 0;
+        std::string ranges;
+        std::uint32_t range_begin = 0;
+        bool in_range = false;
+        for (auto ordinal = first; ordinal < last; ordinal++) {
+            std::uint32_t offset = index.select(ordinal);
+            std::uint32_t adr = section->address + offset;
+            auto insn = decode(get_word(section->data, offset));
+            leaders[0] = true;
+            if (is_control_transfer(insn.op) && ordinal + 1 < last) {
+                leaders[ordinal + 1 - first] = true;
+            }
+            if (has_target(insn)) {
+                std::uint32_t target = adr + insn.imm;
+                if (target >= functions[i].address && target < end && index.is_start(target - section->address)) {
+                    leaders[index.rank(target - section->address) - first] = true;
+                }
+            }
+            if (test_bit(bits, ordinal)) {
+                executed_count++;
+                if (!in_range) {
+                    range_begin = adr;
+                    in_range = true;
+                }
+            } else if (in_range) {
+                ranges += format_range(range_begin, adr);
+                in_range = false;
+            }
+        }
+        auto code_end = [&](std::uint32_t ordinal) {
+            return section->address + (ordinal < index.size() ? index.select(ordinal)
+                                                              : static_cast<std::uint32_t>(section->data.size()));
+        };
+        if (in_range) {
+            ranges += format_range(range_begin, code_end(last));
+        }
+
+        std::string uncovered;
+        for (auto begin = first; begin < last;) {
+            auto block_end = begin + 1;
+            while (block_end < last && !leaders[block_end - first]) {
+                block_end++;
+            }
+            bool reached = false;
+            for (auto ordinal = begin; ordinal < block_end && !reached; ordinal++) {
+                reached = test_bit(bits, ordinal);
+            }
+            if (!reached) {
+                uncovered += format_range(code_end(begin), code_end(block_end));
+            }
+            begin = block_end;
+        }
+
+        std::uint32_t commands = last - first;
+        all_commands += commands;
+        all_executed += executed_count;
+        snprintf(buf, sizeof(buf), ": %u/%u commands (%.2f%%)\n", executed_count, commands,
+                 commands == 0 ? 0.0 : 100.0 * executed_count / commands);
+        out << "\n" << functions[i].name << buf;
+        if (!ranges.empty()) {
+            out << "  executed:" << ranges << "\n";
+        }
+        if (!uncovered.empty()) {
+            out << "  uncovered blocks:" << uncovered << "\n";
+        }
+    }
+    snprintf(buf, sizeof(buf), "\ntotal: %llu/%llu commands (%.2f%%)\n", static_cast<unsigned long long>(all_executed),
+             static_cast<unsigned long long>(all_commands),
+             all_commands == 0 ? 0.0 : 100.0 * all_executed / all_commands);
+    out << buf;
+}
+
+}
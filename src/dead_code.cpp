@@ -0,0 +1,135 @@
+#include "dead_code.h"
+#include "call_graph.h"
+#include "parallel.h"
+#include <cstdio>
+#include <ostream>
+
+namespace Parser {
+
+// functions referenced from functions[i]: calls, jumps and branches into other functions and
+// addresses of function starts put together with lui, c.lui or auipc and addi or jalr
+static std::vector<std::size_t> collect_references(const std::vector<Function>& functions, std::size_t i,
+                                                   const std::vector<CodeSection>& code, const FunctionLookup& lookup,
+                                                   std::vector<std::size_t>& constants) {
+    std::vector<std::size_t> references;
+    auto function_code = get_function_code(functions, i, code);
+    if (function_code.section == nullptr) {
+        return references;
+    }
+    const auto& section = *function_code.section;
+    auto add = [&](std::vector<std::size_t>& to, std::size_t callee) {
+        if (callee != functions.size() && callee != i) {
+            to.push_back(callee);
+        }
+    };
+    std::uint32_t known = 0;  // registers holding a value built by lui/c.lui/auipc
+    std::uint32_t values[32];
+    std::uint32_t origins[32];  // offset of that command, where a call relocation would be
+    for (auto ordinal = function_code.first; ordinal < function_code.last; ordinal++) {
+        auto offset = function_code.section->index.select(ordinal);
+        std::uint32_t adr = function_code.section->address + offset;
+        auto insn = decode(get_word(function_code.section->data, offset));
+        bool rs1_known = (known >> insn.rs1) & 1;
+        std::uint32_t rd = insn.rd;
+        if (insn.op == Op::C_JAL || insn.op == Op::C_JALR) {
+            rd = 1;
+        }
+        if (has_target(insn)) {
+            add(references, lookup.find_target(section, offset, adr + insn.imm));
+        } else if ((insn.op == Op::JALR || insn.op == Op::C_JALR || insn.op == Op::C_JR) && rs1_known) {
+            add(references, lookup.find_target(section, origins[insn.rs1], values[insn.rs1] + insn.imm));
+        }
+
+        // register whose known value plus insn.imm lands in rd, 0 if none
+        std::uint32_t source = 0;
+        if (insn.op == Op::ADDI || insn.op == Op::C_ADDI) {
+            source = insn.rs1;
+        } else if (insn.op == Op::C_MV || (insn.op == Op::ADD && insn.rs1 == 0)) {
+            source = insn.rs2;
+        } else if (insn.op == Op::ADD && insn.rs2 == 0) {
+            source = insn.rs1;
+        }
+        std::int32_t addend = (insn.op == Op::ADDI || insn.op == Op::C_ADDI ? insn.imm : 0);
+
+        if (insn.op == Op::LUI || insn.op == Op::C_LUI || insn.op == Op::AUIPC) {
+            values[rd] = (insn.op == Op::AUIPC ? adr : 0) + insn.imm;
+            origins[rd] = offset;
+            known |= 1u << rd;
+        } else if (source != 0 && ((known >> source) & 1) && rd != 0) {
+            values[rd] = values[source] + addend;
+            origins[rd] = origins[source];
+            known |= 1u << rd;
+            // only exact function starts count as taken addresses, anything else is data
+            auto f = lookup.find(values[rd], section);
+            if (f != functions.size() && functions[f].address == values[rd]) {
+                add(constants, f);
+            }
+        } else {
+            known &= ~(1u << rd);
+        }
+    }
+    return references;
+}
+
+void report_unreferenced(std::istream& in, std::ostream& out, unsigned jobs) {
+    auto entry = read_file_header(in).e_entry;
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, jobs);
+
+    std::vector<std::vector<std::size_t>> references(functions.size());
+    std::vector<std::vector<std::size_t>> constants(functions.size());
+    FunctionLookup lookup(functions);
+    parallel_for(functions.size(), jobs, [&](std::size_t i) {
+        references[i] = collect_references(functions, i, code, lookup, constants[i]);
+    });
+
+    std::vector<std::uint64_t> reached((functions.size() + 63) / 64, 0);
+    std::vector<std::size_t> worklist;
+    auto mark = [&](std::size_t f) {
+        if (f < functions.size() && !((reached[f / 64] >> (f % 64)) & 1)) {
+            reached[f / 64] |= std::uint64_t(1) << (f % 64);
+            worklist.push_back(f);
+        }
+    };
+    if (entry != 0) {
+        mark(find_function_index(functions, entry));
+    }
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        if (functions[i].bind == STB_GLOBAL || functions[i].bind == STB_WEAK) {
+            mark(i);
+        }
+        // a taken address may be stored anywhere, so it keeps its function alive on its own
+        for (auto f : constants[i]) {
+            mark(f);
+        }
+    }
+    while (!worklist.empty()) {
+        auto f = worklist.back();
+        worklist.pop_back();
+        for (auto callee : references[f]) {
+            mark(callee);
+        }
+    }
+
+    std::uint64_t total = 0;
+    std::size_t count = 0;
+    char buf[64];
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        if ((reached[i / 64] >> (i % 64)) & 1) {
+            continue;
+        }
+        auto section = find_function_code(code, functions[i]);
+        std::uint32_t size = (section == nullptr ? functions[i].size
+                                                 : get_function_end(functions, i, *section) - functions[i].address);
+        snprintf(buf, sizeof(buf), "%08x %8u ", functions[i].address, size);
+        out << buf << functions[i].name << "\n";
+        total += size;
+        count++;
+    }
+    snprintf(buf, sizeof(buf), "%zu unreferenced functions, %llu bytes\n", count,
+             static_cast<unsigned long long>(total));
+    out << buf;
+}
+
+}
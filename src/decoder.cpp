@@ -0,0 +1,378 @@
+#include "decoder.h"
+#include <stdexcept>
+
+namespace Parser {
+
+static std::uint32_t get_unsigned(std::uint32_t value, int l, int r) {
+    auto width = r - l + 1;
+    return width == 32 ? value : (value >> l) & ((1u << width) - 1);
+}
+
+static std::int32_t get_signed(std::uint32_t value, int l, int r) {
+    auto width = r - l + 1;
+    auto result = get_unsigned(value, l, r);
+    if (width < 32 && ((result >> (width - 1)) & 1)) {
+        result |= ~((1u << width) - 1);
+    }
+    return static_cast<std::int32_t>(result);
+}
+
+static DecodedInsn make_insn(
+        std::uint32_t raw,
+        Op op,
+        Format format,
+        std::uint32_t rd,
+        std::uint32_t rs1,
+        std::uint32_t rs2,
+        std::int32_t imm
+) {
+    DecodedInsn insn;
+    insn.raw = raw;
+    insn.length = ((raw & 0x3) == 0x3 ? 4 : 2);
+    insn.op = op;
+    insn.format = format;
+    insn.rd = static_cast<std::uint8_t>(rd);
+    insn.rs1 = static_cast<std::uint8_t>(rs1);
+    insn.rs2 = static_cast<std::uint8_t>(rs2);
+    insn.imm = imm;
+    return insn;
+}
+
+static DecodedInsn make_unknown(std::uint32_t raw) {
+    return make_insn(raw, Op::UNKNOWN, Format::NONE, 0, 0, 0, 0);
+}
+
+static DecodedInsn decode_quadrant0(std::uint16_t cmd16) {
+    auto type = get_unsigned(cmd16, 13, 15);
+    auto reg_low = get_unsigned(cmd16, 2, 4) + 8,
+         reg_high = get_unsigned(cmd16, 7, 9) + 8;
+    if (type == 0) {
+        auto value = (get_unsigned(cmd16, 11, 12) << 4) +
+                (get_unsigned(cmd16, 7, 10) << 6) +
+                (get_unsigned(cmd16, 6, 6) << 2) +
+                (get_unsigned(cmd16, 5, 5) << 3);
+        return make_insn(cmd16, Op::C_ADDI4SPN, Format::RD_RS1_IMM, reg_low, 2, 0, value);
+    }
+    if (type == 1 || type == 3 || type == 5) {
+        auto value = static_cast<std::int32_t>((get_unsigned(cmd16, 10, 12) << 3) + (get_unsigned(cmd16, 5, 6) << 6));
+        if (type == 1) {
+            return make_insn(cmd16, Op::C_FLD, Format::LOAD, reg_low, reg_high, 0, value);
+        }
+        if (type == 3) {
+            return make_insn(cmd16, Op::C_LD, Format::LOAD, reg_low, reg_high, 0, value);
+        }
+        return make_insn(cmd16, Op::C_FSD, Format::STORE, 0, reg_high, reg_low, value);
+    }
+    if (type == 2 || type == 6 || type == 7) {
+        auto value = static_cast<std::int32_t>((get_unsigned(cmd16, 10, 12) << 3) +
+                (get_unsigned(cmd16, 6, 6) << 2) +
+                (get_unsigned(cmd16, 5, 5) << 6));
+        if (type == 2) {
+            return make_insn(cmd16, Op::C_LW, Format::LOAD, reg_low, reg_high, 0, value);
+        }
+        return make_insn(cmd16, type == 6 ? Op::C_SW : Op::C_FSW, Format::STORE, 0, reg_high, reg_low, value);
+    }
+    return make_unknown(cmd16);
+}
+
+static std::int32_t get_cj_offset(std::uint16_t cmd16) {
+    auto uvalue = (get_unsigned(cmd16, 12, 12) << 11) +
+            (get_unsigned(cmd16, 11, 11) << 4) +
+            (get_unsigned(cmd16, 9, 10) << 8) +
+            (get_unsigned(cmd16, 8, 8) << 10) +
+            (get_unsigned(cmd16, 7, 7) << 6) +
+            (get_unsigned(cmd16, 6, 6) << 7) +
+            (get_unsigned(cmd16, 3, 5) << 1) +
+            (get_unsigned(cmd16, 2, 2) << 5);
+    return get_signed(uvalue, 0, 11);
+}
+
+static DecodedInsn decode_quadrant1(std::uint16_t cmd16) {
+    if (get_unsigned(cmd16, 2, 15) == 0) {
+        return make_insn(cmd16, Op::C_NOP, Format::NONE, 0, 0, 0, 0);
+    }
+    auto type = get_unsigned(cmd16, 13, 15);
+    auto rd = get_unsigned(cmd16, 7, 11);
+    auto imm6 = get_signed((get_unsigned(cmd16, 12, 12) << 5) + get_unsigned(cmd16, 2, 6), 0, 5);
+    auto reg_high = get_unsigned(cmd16, 7, 9) + 8;
+    switch (type) {
+        case 0: return make_insn(cmd16, Op::C_ADDI, Format::RD_RS1_IMM, rd, rd, 0, imm6);
+        case 1: return make_insn(cmd16, Op::C_JAL, Format::JUMP, 0, 0, 0, get_cj_offset(cmd16));
+        case 2: return make_insn(cmd16, Op::C_LI, Format::RD_IMM, rd, 0, 0, imm6);
+        case 3:
+            if (rd == 2) {
+                auto uvalue = (get_unsigned(cmd16, 12, 12) << 9) +
+                        (get_unsigned(cmd16, 6, 6) << 4) +
+                        (get_unsigned(cmd16, 5, 5) << 6) +
+                        (get_unsigned(cmd16, 3, 4) << 7) +
+                        (get_unsigned(cmd16, 2, 2) << 5);
+                return make_insn(cmd16, Op::C_ADDI16SP, Format::RD_RS1_IMM, 2, 2, 0, get_signed(uvalue, 0, 9));
+            }
+            return make_insn(cmd16, Op::C_LUI, Format::RD_IMM, rd, 0, 0,
+                             get_signed((get_unsigned(cmd16, 12, 12) << 17) + (get_unsigned(cmd16, 2, 6) << 12), 0, 17));
+        case 4: {
+            auto uimm6 = static_cast<std::int32_t>((get_unsigned(cmd16, 12, 12) << 5) + get_unsigned(cmd16, 2, 6));
+            switch (get_unsigned(cmd16, 10, 11)) {
+                case 0: return make_insn(cmd16, Op::C_SRLI, Format::RD_RS1_IMM, reg_high, reg_high, 0, uimm6);
+                case 1: return make_insn(cmd16, Op::C_SRAI, Format::RD_RS1_IMM, reg_high, reg_high, 0, uimm6);
+                case 2: return make_insn(cmd16, Op::C_ANDI, Format::RD_RS1_IMM, reg_high, reg_high, 0, imm6);
+                default: {
+                    static const Op ops[] = {Op::C_SUB, Op::C_XOR, Op::C_OR, Op::C_AND, Op::C_SUBW, Op::C_ADDW};
+                    auto type2 = (get_unsigned(cmd16, 12, 12) << 2) + get_unsigned(cmd16, 5, 6);
+                    if (type2 >= sizeof(ops) / sizeof(ops[0])) {
+                        return make_unknown(cmd16);
+                    }
+                    return make_insn(cmd16, ops[type2], Format::RD_RS1_RS2, reg_high, reg_high,
+                                     get_unsigned(cmd16, 2, 4) + 8, 0);
+                }
+            }
+        }
+        case 5: return make_insn(cmd16, Op::C_J, Format::JUMP, 0, 0, 0, get_cj_offset(cmd16));
+        default: {
+            auto uvalue = (get_unsigned(cmd16, 12, 12) << 8) +
+                    (get_unsigned(cmd16, 10, 11) << 3) +
+                    (get_unsigned(cmd16, 5, 6) << 6) +
+                    (get_unsigned(cmd16, 3, 4) << 1) +
+                    (get_unsigned(cmd16, 2, 2) << 5);
+            return make_insn(cmd16, type == 6 ? Op::C_BEQZ : Op::C_BNEZ, Format::RS1_JUMP, 0, reg_high, 0,
+                             get_signed(uvalue, 0, 8));
+        }
+    }
+}
+
+static DecodedInsn decode_quadrant2(std::uint16_t cmd16) {
+    auto type = get_unsigned(cmd16, 13, 15);
+    auto rd = get_unsigned(cmd16, 7, 11),
+         rs2 = get_unsigned(cmd16, 2, 6);
+    switch (type) {
+        case 0:
+            return make_insn(cmd16, Op::C_SLLI, Format::RD_RS1_IMM, rd, rd, 0,
+                             (get_unsigned(cmd16, 12, 12) << 5) + get_unsigned(cmd16, 2, 6));
+        case 1: {
+            auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
+                    (get_unsigned(cmd16, 5, 6) << 3) +
+                    (get_unsigned(cmd16, 2, 4) << 6);
+            return make_insn(cmd16, Op::C_FLDSP, Format::LOAD, rd, 2, 0, uvalue);
+        }
+        case 2:
+        case 3: {
+            auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
+                    (get_unsigned(cmd16, 4, 6) << 2) +
+                    (get_unsigned(cmd16, 2, 3) << 6);
+            return make_insn(cmd16, type == 2 ? Op::C_LWSP : Op::C_FLWSP, Format::LOAD, rd, 2, 0, uvalue);
+        }
+        case 4:
+            if (rs2 != 0) {
+                if (get_unsigned(cmd16, 12, 12)) {
+                    return make_insn(cmd16, Op::C_ADD, Format::RD_RS1_RS2, rd, rd, rs2, 0);
+                }
+                return make_insn(cmd16, Op::C_MV, Format::RD_RS2, rd, 0, rs2, 0);
+            }
+            if (get_unsigned(cmd16, 7, 15) == 0x120) {
+                return make_insn(cmd16, Op::C_EBREAK, Format::NONE, 0, 0, 0, 0);
+            }
+            return make_insn(cmd16, get_unsigned(cmd16, 12, 12) ? Op::C_JALR : Op::C_JR, Format::RS1, 0, rd, 0, 0);
+        case 5: {
+            auto uvalue = (get_unsigned(cmd16, 10, 12) << 3) + (get_unsigned(cmd16, 7, 9) << 6);
+            return make_insn(cmd16, Op::C_FSDSP, Format::STORE, 0, 2, rs2, uvalue);
+        }
+        default: {
+            auto uvalue = (get_unsigned(cmd16, 9, 12) << 2) + (get_unsigned(cmd16, 7, 8) << 6);
+            return make_insn(cmd16, type == 6 ? Op::C_SWSP : Op::C_FSWSP, Format::STORE, 0, 2, rs2, uvalue);
+        }
+    }
+}
+
+static DecodedInsn decode_cmd32(std::uint32_t cmd32) {
+    auto rd = get_unsigned(cmd32, 7, 11),
+         rs1 = get_unsigned(cmd32, 15, 19),
+         rs2 = get_unsigned(cmd32, 20, 24),
+         funct3 = get_unsigned(cmd32, 12, 14);
+    auto imm12 = get_signed(cmd32, 20, 31);
+    switch (get_unsigned(cmd32, 0, 6)) {
+        case 0x37: return make_insn(cmd32, Op::LUI, Format::RD_IMM, rd, 0, 0, get_signed(cmd32 & 0xfffff000, 0, 31));
+        case 0x17: return make_insn(cmd32, Op::AUIPC, Format::RD_IMM, rd, 0, 0, get_signed(cmd32 & 0xfffff000, 0, 31));
+        case 0x13: {
+            static const Op ops[] = {Op::ADDI, Op::SLLI, Op::SLTI, Op::SLTIU, Op::XORI, Op::SRLI, Op::ORI, Op::ANDI};
+            if (funct3 == 1 || funct3 == 5) {
+                auto op = (funct3 == 5 && get_unsigned(cmd32, 30, 30) ? Op::SRAI : ops[funct3]);
+                return make_insn(cmd32, op, Format::RD_RS1_IMM, rd, rs1, 0, rs2);
+            }
+            return make_insn(cmd32, ops[funct3], Format::RD_RS1_IMM, rd, rs1, 0, imm12);
+        }
+        case 0x33: {
+            auto funct7_low = get_unsigned(cmd32, 25, 26);
+            if (funct7_low == 0) {
+                static const Op ops[] = {Op::ADD, Op::SLL, Op::SLT, Op::SLTU, Op::XOR, Op::SRL, Op::OR, Op::AND};
+                auto funct7_high = get_unsigned(cmd32, 27, 31);
+                Op op = Op::UNKNOWN;
+                if (funct7_high == 0) {
+                    op = ops[funct3];
+                } else if (funct7_high == 8 && funct3 == 0) {
+                    op = Op::SUB;
+                } else if (funct7_high == 8 && funct3 == 5) {
+                    op = Op::SRA;
+                }
+                return make_insn(cmd32, op, Format::RD_RS1_RS2, rd, rs1, rs2, 0);
+            }
+            if (funct7_low == 1) {
+                static const Op ops[] = {Op::MUL, Op::MULH, Op::MULHSU, Op::MULHU, Op::DIV, Op::DIVU, Op::REM, Op::REMU};
+                return make_insn(cmd32, ops[funct3], Format::RD_RS1_RS2, rd, rs1, rs2, 0);
+            }
+            return make_unknown(cmd32);
+        }
+        case 0x03: {
+            static const Op ops[] = {Op::LB, Op::LH, Op::LW, Op::UNKNOWN, Op::LBU, Op::LHU, Op::UNKNOWN, Op::UNKNOWN};
+            return make_insn(cmd32, ops[funct3], Format::LOAD, rd, rs1, 0, imm12);
+        }
+        case 0x23: {
+            static const Op ops[] = {Op::SB, Op::SH, Op::SW, Op::UNKNOWN, Op::UNKNOWN, Op::UNKNOWN, Op::UNKNOWN, Op::UNKNOWN};
+            auto value = get_signed((get_unsigned(cmd32, 25, 31) << 5) + get_unsigned(cmd32, 7, 11), 0, 11);
+            return make_insn(cmd32, ops[funct3], Format::STORE, 0, rs1, rs2, value);
+        }
+        case 0x6f: {
+            auto uvalue = (get_unsigned(cmd32, 31, 31) << 20) +
+                    (get_unsigned(cmd32, 21, 30) << 1) +
+                    (get_unsigned(cmd32, 20, 20) << 11) +
+                    (get_unsigned(cmd32, 12, 19) << 12);
+            return make_insn(cmd32, Op::JAL, Format::RD_JUMP, rd, 0, 0, get_signed(uvalue, 0, 20));
+        }
+        case 0x67: return make_insn(cmd32, Op::JALR, Format::RD_RS1_IMM, rd, rs1, 0, imm12);
+        case 0x63: {
+            static const Op ops[] = {Op::BEQ, Op::BNE, Op::UNKNOWN, Op::UNKNOWN, Op::BLT, Op::BGE, Op::BLTU, Op::BGEU};
+            auto uvalue = (get_unsigned(cmd32, 31, 31) << 12) +
+                    (get_unsigned(cmd32, 25, 30) << 5) +
+                    (get_unsigned(cmd32, 8, 11) << 1) +
+                    (get_unsigned(cmd32, 7, 7) << 11);
+            return make_insn(cmd32, ops[funct3], Format::RS1_RS2_JUMP, 0, rs1, rs2, get_signed(uvalue, 0, 12));
+        }
+        default: return make_unknown(cmd32);
+    }
+}
+
+DecodedInsn decode(std::uint32_t word) {
+    auto cmd16 = static_cast<std::uint16_t>(word);
+    switch (cmd16 & 0x3) {
+        case 0: return decode_quadrant0(cmd16);
+        case 1: return decode_quadrant1(cmd16);
+        case 2: return decode_quadrant2(cmd16);
+        default: return decode_cmd32(word);
+    }
+}
+
+std::uint32_t get_word(const std::vector<char>& code, std::uint32_t offset) {
+    std::uint32_t word = 0;
+    for (std::uint32_t i = 0; i < 4 && offset + i < code.size(); i++) {
+        word |= static_cast<std::uint32_t>(static_cast<unsigned char>(code[offset + i])) << (8 * i);
+    }
+    return word;
+}
+
+bool is_control_transfer(Op op) {
+    switch (op) {
+        case Op::C_JAL:
+        case Op::C_J:
+        case Op::C_BEQZ:
+        case Op::C_BNEZ:
+        case Op::C_EBREAK:
+        case Op::C_JR:
+        case Op::C_JALR:
+        case Op::JAL:
+        case Op::JALR:
+        case Op::BEQ:
+        case Op::BNE:
+        case Op::BLT:
+        case Op::BGE:
+        case Op::BLTU:
+        case Op::BGEU:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool has_target(const DecodedInsn& insn) {
+    return insn.format == Format::JUMP || insn.format == Format::RD_JUMP ||
+            insn.format == Format::RS1_JUMP || insn.format == Format::RS1_RS2_JUMP;
+}
+
+const char* get_op_name(Op op) {
+    static const char* names[] = {
+        "unknown_command",
+        "c.addi4spn", "c.fld", "c.ld", "c.fsd", "c.lw", "c.sw", "c.fsw",
+        "c.nop", "c.addi", "c.jal", "c.li", "c.addi16sp", "c.lui", "c.srli", "c.srai", "c.andi",
+        "c.sub", "c.xor", "c.or", "c.and", "c.subw", "c.addw", "c.j", "c.beqz", "c.bnez",
+        "c.slli", "c.fldsp", "c.lwsp", "c.flwsp", "c.add", "c.mv", "c.ebreak", "c.jr", "c.jalr", "c.fsdsp", "c.swsp", "c.fswsp",
+        "lui", "auipc",
+        "addi", "slti", "sltiu", "xori", "ori", "andi", "slli", "srli", "srai",
+        "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and",
+        "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu",
+        "lb", "lh", "lw", "lbu", "lhu", "sb", "sh", "sw",
+        "jal", "jalr", "beq", "bne", "blt", "bge", "bltu", "bgeu"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(Op::COUNT), "every op needs a name");
+    return names[static_cast<std::size_t>(op)];
+}
+
+std::string get_reg(std::uint32_t id) {
+    if (id == 0)
+        return "zero";
+    if (id == 1)
+        return "ra";
+    if (id == 2)
+        return "sp";
+    if (id == 3)
+        return "gp";
+    if (id == 4)
+        return "tp";
+    if (id >= 5 && id <= 7)
+        return "t" + std::to_string(id - 5);
+    if (id == 8 || id == 9)
+        return "s" + std::to_string(id - 8);
+    if (id >= 10 && id <= 17)
+        return "a" + std::to_string(id - 10);
+    if (id >= 18 && id <= 27)
+        return "s" + std::to_string(id - 16);
+    if (id >= 28 && id <= 31)
+        return "t" + std::to_string(id - 25);
+    throw std::invalid_argument("unknown register");
+}
+
+const std::vector<Pattern>& get_patterns() {
+    static const std::vector<Pattern> patterns = {
+        {Op::C_ADDI4SPN, 0xe003, 0x0000}, {Op::C_FLD, 0xe003, 0x2000}, {Op::C_LD, 0xe003, 0x6000},
+        {Op::C_FSD, 0xe003, 0xa000}, {Op::C_LW, 0xe003, 0x4000}, {Op::C_SW, 0xe003, 0xc000},
+        {Op::C_FSW, 0xe003, 0xe000},
+        {Op::C_NOP, 0xffff, 0x0001}, {Op::C_ADDI, 0xe003, 0x0001}, {Op::C_JAL, 0xe003, 0x2001},
+        {Op::C_LI, 0xe003, 0x4001}, {Op::C_ADDI16SP, 0xef83, 0x6101}, {Op::C_LUI, 0xe003, 0x6001},
+        {Op::C_SRLI, 0xec03, 0x8001}, {Op::C_SRAI, 0xec03, 0x8401}, {Op::C_ANDI, 0xec03, 0x8801},
+        {Op::C_SUB, 0xfc63, 0x8c01}, {Op::C_XOR, 0xfc63, 0x8c21}, {Op::C_OR, 0xfc63, 0x8c41},
+        {Op::C_AND, 0xfc63, 0x8c61}, {Op::C_SUBW, 0xfc63, 0x9c01}, {Op::C_ADDW, 0xfc63, 0x9c21},
+        {Op::C_J, 0xe003, 0xa001}, {Op::C_BEQZ, 0xe003, 0xc001}, {Op::C_BNEZ, 0xe003, 0xe001},
+        {Op::C_SLLI, 0xe003, 0x0002}, {Op::C_FLDSP, 0xe003, 0x2002}, {Op::C_LWSP, 0xe003, 0x4002},
+        {Op::C_FLWSP, 0xe003, 0x6002}, {Op::C_ADD, 0xf003, 0x9002}, {Op::C_MV, 0xf003, 0x8002},
+        {Op::C_EBREAK, 0xffff, 0x9002}, {Op::C_JR, 0xf07f, 0x8002}, {Op::C_JALR, 0xf07f, 0x9002},
+        {Op::C_FSDSP, 0xe003, 0xa002}, {Op::C_SWSP, 0xe003, 0xc002}, {Op::C_FSWSP, 0xe003, 0xe002},
+        {Op::LUI, 0x7f, 0x37}, {Op::AUIPC, 0x7f, 0x17},
+        {Op::ADDI, 0x707f, 0x0013}, {Op::SLTI, 0x707f, 0x2013}, {Op::SLTIU, 0x707f, 0x3013},
+        {Op::XORI, 0x707f, 0x4013}, {Op::ORI, 0x707f, 0x6013}, {Op::ANDI, 0x707f, 0x7013},
+        {Op::SLLI, 0x707f, 0x1013}, {Op::SRLI, 0x4000707f, 0x5013}, {Op::SRAI, 0x4000707f, 0x40005013},
+        {Op::ADD, 0xfe00707f, 0x0033}, {Op::SUB, 0xfe00707f, 0x40000033}, {Op::SLL, 0xfe00707f, 0x1033},
+        {Op::SLT, 0xfe00707f, 0x2033}, {Op::SLTU, 0xfe00707f, 0x3033}, {Op::XOR, 0xfe00707f, 0x4033},
+        {Op::SRL, 0xfe00707f, 0x5033}, {Op::SRA, 0xfe00707f, 0x40005033}, {Op::OR, 0xfe00707f, 0x6033},
+        {Op::AND, 0xfe00707f, 0x7033},
+        {Op::MUL, 0x0600707f, 0x02000033}, {Op::MULH, 0x0600707f, 0x02001033},
+        {Op::MULHSU, 0x0600707f, 0x02002033}, {Op::MULHU, 0x0600707f, 0x02003033},
+        {Op::DIV, 0x0600707f, 0x02004033}, {Op::DIVU, 0x0600707f, 0x02005033},
+        {Op::REM, 0x0600707f, 0x02006033}, {Op::REMU, 0x0600707f, 0x02007033},
+        {Op::LB, 0x707f, 0x0003}, {Op::LH, 0x707f, 0x1003}, {Op::LW, 0x707f, 0x2003},
+        {Op::LBU, 0x707f, 0x4003}, {Op::LHU, 0x707f, 0x5003},
+        {Op::SB, 0x707f, 0x0023}, {Op::SH, 0x707f, 0x1023}, {Op::SW, 0x707f, 0x2023},
+        {Op::JAL, 0x7f, 0x6f}, {Op::JALR, 0x7f, 0x67},
+        {Op::BEQ, 0x707f, 0x0063}, {Op::BNE, 0x707f, 0x1063}, {Op::BLT, 0x707f, 0x4063},
+        {Op::BGE, 0x707f, 0x5063}, {Op::BLTU, 0x707f, 0x6063}, {Op::BGEU, 0x707f, 0x7063}
+    };
+    return patterns;
+}
+
+}
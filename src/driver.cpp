@@ -0,0 +1,157 @@
+#include "driver.h"
+#include "archive.h"
+#include "call_graph.h"
+#include "compress.h"
+#include "coverage.h"
+#include "dead_code.h"
+#include "elf_parser.h"
+#include "encoder.h"
+#include "function_filter.h"
+#include "parallel.h"
+#include "profile.h"
+#include "rvc_report.h"
+#include "search.h"
+#include "simulator.h"
+#include "size_report.h"
+#include "stack_report.h"
+#include "sweep.h"
+#include "trace.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace Parser {
+
+// cache is only used and counted by the listing
+static void render(std::istream& in, std::ostream& out, const Options& options, FormatCache& cache) {
+    if (!options.search.empty()) {
+        search(in, out, options.search);
+    } else if (!options.trace.empty()) {
+        annotate_trace(in, out, options.trace, options.trace_format);
+    } else if (!options.samples.empty()) {
+        annotate_samples(in, out, options.samples, options.trace_format);
+    } else if (!options.coverage.empty()) {
+        report_coverage(in, out, options.coverage, options.trace_format, options.jobs);
+    } else if (options.size_report != SizeReport::NONE) {
+        report_sizes(in, out, options.size_report, options.jobs);
+    } else if (options.rvc_report) {
+        report_rvc(in, out, options.jobs);
+    } else if (options.stack_report) {
+        report_stack(in, out);
+    } else if (options.call_graph != CallGraphFormat::NONE) {
+        export_call_graph(in, out, options.call_graph, options.jobs);
+    } else if (options.unreferenced) {
+        report_unreferenced(in, out, options.jobs);
+    } else if (options.verify) {
+        verify_encoding(in, out, options.jobs);
+    } else if (!options.functions.empty()) {
+        disassemble_functions(in, out, options);
+    } else if (options.simulate) {
+        simulate(in, out, options.simulate_entry, options.max_steps);
+    } else {
+        parse(in, out, options, &cache);
+    }
+}
+
+// on stderr, since stdout carries the replies in worker mode
+static void print_stats(const FormatCache& cache) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Format cache: %llu of %llu lookups hit (%.2f%%)",
+             static_cast<unsigned long long>(cache.hits), static_cast<unsigned long long>(cache.lookups),
+             cache.lookups == 0 ? 0.0 : 100.0 * cache.hits / cache.lookups);
+    std::cerr << buf << std::endl;
+}
+
+// Every ELF member of a mapped archive is rendered on its own thread into its own buffer; the
+// listings are written in archive order, each after a "name:" line.
+// Cache counters of all members add up in `cache`.
+static void render_archive(const std::string& input_file_name, std::ostream& out, const Options& options,
+                           FormatCache& cache) {
+    // members are rendered into buffers of their own, so their offsets are not output offsets
+    if (!options.line_index.empty()) {
+        throw std::invalid_argument("--line-index can't be used on archives");
+    }
+    MappedFile file(input_file_name);
+    auto members = read_archive_members(file.data(), file.size());
+    auto member_options = options;
+    if (members.size() > 1) {
+        member_options.jobs = 1;
+    }
+    std::vector<std::string> listings(members.size());
+    std::vector<FormatCache> caches(members.size());
+    parallel_for(members.size(), options.jobs, [&](std::size_t i) {
+        const auto& member = members[i];
+        const char* data = file.data() + member.offset;
+        if (member.size < 4 || std::memcmp(data, "\x7f" "ELF", 4) != 0) {
+            listings[i] = "not an ELF file, skipped\n";
+            return;
+        }
+        MemoryBuffer buffer(data, member.size);
+        std::istream in(&buffer);
+        in.exceptions(std::istream::failbit | std::istream::eofbit);
+        std::ostringstream listing;
+        try {
+            render(in, listing, member_options, caches[i]);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument(member.name + ": " + e.what());
+        }
+        listings[i] = listing.str();
+    });
+    for (std::size_t i = 0; i < members.size(); i++) {
+        out << (i == 0 ? "" : "\n") << members[i].name << ":\n" << listings[i];
+        cache.lookups += caches[i].lookups;
+        cache.hits += caches[i].hits;
+    }
+}
+
+static void render_input(const std::string& input_file_name, std::ostream& out, const Options& options) {
+    std::ifstream in(input_file_name, std::ios::binary);
+    in.exceptions(std::ifstream::failbit | std::ifstream::eofbit);
+
+    FormatCache cache;
+    if (is_archive(in)) {
+        render_archive(input_file_name, out, options, cache);
+    } else {
+        render(in, out, options, cache);
+    }
+    if (options.stats) {
+        print_stats(cache);
+    }
+}
+
+static std::ofstream open_output(const std::string& file_name, std::ios::openmode mode = std::ios::out) {
+    std::ofstream out(file_name, mode);
+    if (!out) {
+        throw std::invalid_argument("can't open output file " + file_name);
+    }
+    return out;
+}
+
+void run(const std::string& input_file_name, const std::string& output_file_name, const Options& options) {
+    if (options.compression == Compression::NONE) {
+        auto out = open_output(output_file_name);
+        render_input(input_file_name, out, options);
+        return;
+    }
+    check_compression(options.compression);
+    auto out = open_output(output_file_name, std::ios::binary);
+    CompressingBuffer buffer(out, options.compression, options.jobs);
+    std::ostream compressed(&buffer);
+    // a failed block rethrows instead of only setting badbit
+    compressed.exceptions(std::ostream::badbit);
+    render_input(input_file_name, compressed, options);
+    buffer.finish();
+}
+
+void run_sweep(const std::string& output_file_name, const Options& options) {
+    std::uint64_t end = options.sweep_range.end;
+    if (end == std::numeric_limits<std::uint32_t>::max()) {
+        end = std::uint64_t(1) << 32;
+    }
+    auto out = open_output(output_file_name);
+    sweep(out, options.sweep_range.begin, end, options.sweep_format, options.jobs);
+}
+
+}
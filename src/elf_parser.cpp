@@ -1,11 +1,20 @@
 #include "elf_parser.h"
+#include "instruction_index.h"
+#include "decoder.h"
+#include "compress.h"
+#include "parallel.h"
 #include <fstream>
 #include <vector>
 #include <string>
 #include <cstdio>
 #include <stdexcept>
-#include <bitset>
 #include <map>
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace Parser {
 
@@ -51,8 +60,12 @@ static std::string get_visibility(std::uint8_t x) {
     }
 }
 
-static std::string get_index(std::uint16_t x) {
-    switch (x) {
+// reserved st_shndx values print by name, except SHN_XINDEX, whose real index is in `shndx`
+static std::string get_index(const Elf32_Sym& sym, std::size_t id, const std::vector<char>& shndx) {
+    if (sym.st_shndx == SHN_XINDEX && (id + 1) * sizeof(std::uint32_t) <= shndx.size()) {
+        return std::to_string(get_symbol_section(sym, id, shndx));
+    }
+    switch (sym.st_shndx) {
         case 0: return "UNDEF";
         case 0xfff1: return "ABS";
         case 0xff00: return "LOPROC";
@@ -61,11 +74,11 @@ static std::string get_index(std::uint16_t x) {
         case 0xff3f: return "HIOS";
         case 0xfff2: return "COMMON";
         case 0xffff: return "XINDEX";
-        default: return std::to_string(x);
+        default: return std::to_string(sym.st_shndx);
     }
 }
 
-static std::string get_name(std::ifstream& in, std::uint32_t offset_inside_strtab, std::uint32_t strtab_offset) {
+static std::string get_name(std::istream& in, std::uint32_t offset_inside_strtab, std::uint32_t strtab_offset) {
     if (offset_inside_strtab == 0) {
         return "";
     }
@@ -80,7 +93,32 @@ static std::string get_name(std::ifstream& in, std::uint32_t offset_inside_strta
     return name;
 }
 
-static std::uint32_t find_section(const std::vector<Elf32_section_header>& section_headers, int section_type_id) {
+std::vector<char> read_symtab_shndx(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& section_headers,
+        std::uint32_t symtab_id
+) {
+    for (const auto& s_header : section_headers) {
+        if (s_header.sh_type == SYMTAB_SHNDX_TYPE && s_header.sh_link == symtab_id) {
+            return read_section(in, s_header);
+        }
+    }
+    return std::vector<char>();
+}
+
+std::uint32_t get_symbol_section(const Elf32_Sym& sym, std::size_t id, const std::vector<char>& shndx) {
+    if (sym.st_shndx < SHN_LORESERVE) {
+        return sym.st_shndx;
+    }
+    if (sym.st_shndx != SHN_XINDEX || (id + 1) * sizeof(std::uint32_t) > shndx.size()) {
+        return NO_SECTION;
+    }
+    std::uint32_t index;
+    std::memcpy(&index, shndx.data() + id * sizeof(index), sizeof(index));
+    return index;
+}
+
+std::uint32_t find_section(const std::vector<Elf32_section_header>& section_headers, int section_type_id) {
     for (std::size_t i = 0; i < section_headers.size(); i++) {
         if (section_headers[i].sh_type == section_type_id) {
             return i;
@@ -91,62 +129,162 @@ static std::uint32_t find_section(const std::vector<Elf32_section_header>& secti
 
 static const int MAX_LENGTH = 10000;
 
-static void parse_symtab (
-        std::ifstream& in,
-        std::ofstream& out,
-        std::vector<Elf32_section_header>& section_headers
+static void print_symbol(
+        std::ostream& out,
+        std::size_t id,
+        const Elf32_Sym& sym,
+        const std::string& index,
+        const std::string& name
+) {
+    thread_local char buf[MAX_LENGTH];
+    sprintf(buf, "[%4i] 0x%-15X %5i %-8s %-8s %-8s %6s %s\n",
+            static_cast<int>(id),
+            sym.st_value,
+            sym.st_size,
+            get_type(sym.st_info).c_str(),
+            get_bind(sym.st_info).c_str(),
+            get_visibility(sym.st_other).c_str(),
+            index.c_str(),
+            name.c_str()
+    );
+    out.write(buf, static_cast<int>(std::string(buf).size()));
+}
+
+// Columns of one symbol table, so that filters and sort keys read only the fields they need.
+struct SymbolColumns {
+    std::vector<std::uint32_t> value;
+    std::vector<std::uint32_t> size;
+    std::vector<std::uint8_t> info;
+    std::vector<std::uint8_t> other;
+    std::vector<std::uint16_t> shndx;
+    std::vector<std::string> name;
+
+    Elf32_Sym get(std::size_t i) const {
+        return Elf32_Sym{0, value[i], size[i], info[i], other[i], shndx[i]};
+    }
+};
+
+static SymbolColumns read_symbol_columns(const std::vector<char>& symbols, const std::vector<char>& strtab) {
+    SymbolColumns columns;
+    std::size_t count = symbols.size() / sizeof(Elf32_Sym);
+    columns.value.resize(count);
+    columns.size.resize(count);
+    columns.info.resize(count);
+    columns.other.resize(count);
+    columns.shndx.resize(count);
+    columns.name.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        Elf32_Sym sym;
+        std::memcpy(&sym, symbols.data() + i * sizeof(sym), sizeof(sym));
+        columns.value[i] = sym.st_value;
+        columns.size[i] = sym.st_size;
+        columns.info[i] = sym.st_info;
+        columns.other[i] = sym.st_other;
+        columns.shndx[i] = sym.st_shndx;
+        if (sym.st_name != 0 && sym.st_name < strtab.size()) {
+            columns.name[i].assign(strtab.data() + sym.st_name, strnlen(strtab.data() + sym.st_name, strtab.size() - sym.st_name));
+        }
+    }
+    return columns;
+}
+
+static void print_selected_symbols(
+        std::ostream& out,
+        const std::vector<char>& symbols,
+        const std::vector<char>& shndx,
+        const std::vector<char>& strtab,
+        const Options& options
+) {
+    auto columns = read_symbol_columns(symbols, strtab);
+    std::vector<std::uint32_t> rows;
+    for (std::uint32_t i = 0; i < columns.value.size(); i++) {
+        if ((options.sym_type.empty() || get_type(columns.info[i]) == options.sym_type) &&
+                (options.sym_bind.empty() || get_bind(columns.info[i]) == options.sym_bind) &&
+                (options.sym_section.empty() || get_index(columns.get(i), i, shndx) == options.sym_section)) {
+            rows.push_back(i);
+        }
+    }
+    // ties keep table order, so the output does not depend on the number of threads
+    switch (options.sym_sort) {
+        case SymbolSort::ADDRESS:
+            parallel_sort(rows, options.jobs, [&](std::uint32_t a, std::uint32_t b) {
+                return columns.value[a] != columns.value[b] ? columns.value[a] < columns.value[b] : a < b;
+            });
+            break;
+        case SymbolSort::SIZE:
+            parallel_sort(rows, options.jobs, [&](std::uint32_t a, std::uint32_t b) {
+                return columns.size[a] != columns.size[b] ? columns.size[a] > columns.size[b] : a < b;
+            });
+            break;
+        case SymbolSort::NAME:
+            parallel_sort(rows, options.jobs, [&](std::uint32_t a, std::uint32_t b) {
+                int order = columns.name[a].compare(columns.name[b]);
+                return order != 0 ? order < 0 : a < b;
+            });
+            break;
+        case SymbolSort::NONE:
+            break;
+    }
+    for (auto i : rows) {
+        auto sym = columns.get(i);
+        print_symbol(out, i, sym, get_index(sym, i, shndx), columns.name[i]);
+    }
+}
+
+void parse_symtab (
+        std::istream& in,
+        std::ostream& out,
+        std::vector<Elf32_section_header>& section_headers,
+        const Options& options
 ) {
-    auto strtab_offset = section_headers[find_section(section_headers, STRTAB_TYPE)].sh_offset;
+    const auto& strtab_header = section_headers[find_section(section_headers, STRTAB_TYPE)];
+    auto strtab_offset = strtab_header.sh_offset;
+    // compressed tables can't be read in place, the in-memory path handles them in table order
+    bool selected = options.sym_sort != SymbolSort::NONE || !options.sym_type.empty() ||
+            !options.sym_bind.empty() || !options.sym_section.empty() || (strtab_header.sh_flags & SHF_COMPRESSED);
 
-    static char buf[MAX_LENGTH];
+    thread_local char buf[MAX_LENGTH];
 
     sprintf(buf, "%s %-15s %7s %-8s %-8s %-8s %6s %s\n",
             "Symbol", "Value", "Size", "Type", "Bind", "Vis", "Index", "Name");
 
     out.write(buf, static_cast<int>(std::string(buf).size()));
 
-    for (auto s_header : section_headers) {
+    for (std::uint32_t symtab_id = 0; symtab_id < section_headers.size(); symtab_id++) {
+        const auto& s_header = section_headers[symtab_id];
         if (s_header.sh_type == SYMTAB_TYPE) {
+            auto shndx = read_symtab_shndx(in, section_headers, symtab_id);
+            if (selected || (s_header.sh_flags & SHF_COMPRESSED)) {
+                print_selected_symbols(out, read_section(in, s_header), shndx, read_section(in, strtab_header), options);
+                continue;
+            }
             for (std::size_t id_in_section = 0; id_in_section < s_header.sh_size / sizeof(Elf32_Sym); id_in_section++) {
                 in.seekg(static_cast<int>(s_header.sh_offset + id_in_section * sizeof(Elf32_Sym)));
 
                 Elf32_Sym sym;
                 in.read(reinterpret_cast<char *>(&sym), sizeof(sym));
 
-                sprintf(buf, "[%4i] 0x%-15X %5i %-8s %-8s %-8s %6s %s\n",
-                        id_in_section,
-                        sym.st_value,
-                        sym.st_size,
-                        get_type(sym.st_info).c_str(),
-                        get_bind(sym.st_info).c_str(),
-                        get_visibility(sym.st_other).c_str(),
-                        get_index(sym.st_shndx).c_str(),
-                        get_name(in, sym.st_name, strtab_offset).c_str()
-                );
-                out.write(buf, static_cast<int>(std::string(buf).size()));
+                print_symbol(out, id_in_section, sym, get_index(sym, id_in_section, shndx),
+                             get_name(in, sym.st_name, strtab_offset));
             }
         }
     }
 }
 
-static std::map<std::uint32_t, std::string> calc_tags (
-        std::ifstream& in,
+std::map<std::uint32_t, std::string> calc_tags (
+        std::istream& in,
         std::vector<Elf32_section_header>& section_headers
 ) {
     std::map<std::uint32_t, std::string> tags;
-    auto strtab_offset = section_headers[find_section(section_headers, STRTAB_TYPE)].sh_offset;
+    // read whole, since a compressed table can't be read in place
+    auto strtab = read_section(in, section_headers[find_section(section_headers, STRTAB_TYPE)]);
 
     for (auto s_header : section_headers) {
         if (s_header.sh_type == SYMTAB_TYPE) {
-            for (std::size_t id_in_section = 0; id_in_section < s_header.sh_size / sizeof(Elf32_Sym); id_in_section++) {
-                in.seekg(static_cast<int>(s_header.sh_offset + id_in_section * sizeof(Elf32_Sym)));
-
-                Elf32_Sym sym;
-                in.read(reinterpret_cast<char *>(&sym), sizeof(sym));
-
-                auto name = get_name(in, sym.st_name, strtab_offset);
-                if (!name.empty()) {
-                    tags[sym.st_value] = name;
+            auto columns = read_symbol_columns(read_section(in, s_header), strtab);
+            for (std::size_t i = 0; i < columns.name.size(); i++) {
+                if (!columns.name[i].empty()) {
+                    tags[columns.value[i]] = columns.name[i];
                 }
             }
         }
@@ -154,42 +292,11 @@ static std::map<std::uint32_t, std::string> calc_tags (
     return tags;
 }
 
-static std::string get_segment(std::uint16_t cmd, int l, int r) {
-    return std::bitset<16>(cmd).to_string().substr(16 - r - 1, r - l + 1);
-}
-
-static std::string get_segment(std::uint32_t cmd, int l, int r) {
-    return std::bitset<32>(cmd).to_string().substr(32 - r - 1, r - l + 1);
-}
-
-std::uint32_t get_cmd32(std::ifstream& in, std::uint16_t cmd16) {
-    std::uint32_t cmd32 = cmd16;
-    in.read(reinterpret_cast<char *>(&cmd16), sizeof(cmd16));
-    cmd32 = (cmd16 << 16) | cmd32;
-    return cmd32;
-}
-
 const char* print_format[2][4] = {{"%s\n", "%s %s\n", "%s %s, %s\n", "%s %s, %s, %s\n"},
                                   {"%s()\n", "%s(%s)\n", "%s %s(%s)\n", "%s %s, %s(%s)\n"}};
 
-static void print_cmd (
-        std::ofstream& out,
-        std::uint32_t adr,
-        const std::string& tag,
-        const std::vector<std::string>& args,
-        bool is_load_store = false
-) {
-    if (tag.empty()) {
-        static char buf_title[25];
-        sprintf(buf_title, "%08x", adr);
-        out.write(buf_title, static_cast<int>(std::string(buf_title).size()));
-        out.write(std::string(13, ' ').c_str(), 13);
-    } else {
-        static char buf_title[MAX_LENGTH];
-        sprintf(buf_title, "%08x %10s: ", adr, tag.c_str());
-        out.write(buf_title, static_cast<int>(std::string(buf_title).size()));
-    }
-    static char buf[4][MAX_LENGTH];
+static std::string format_cmd(const std::vector<std::string>& args, bool is_load_store) {
+    thread_local char buf[4][MAX_LENGTH];
     switch (args.size()) {
         case 1: sprintf(buf[0], print_format[is_load_store][0], args[0].c_str());
                 break;
@@ -201,587 +308,326 @@ static void print_cmd (
                 break;
         default: throw std::invalid_argument("wrong number of arguments for print_cmd function");
     }
-    out.write(buf[args.size() - 1], static_cast<int>(std::string(buf[args.size() - 1]).size()));
+    return buf[args.size() - 1];
 }
 
-static std::uint32_t get_unsigned(std::uint32_t value, int l, int r) {
-    std::uint32_t result = 0;
-    for (std::size_t i = l; i <= r; i++) {
-        if ((value >> i) & 1) {
-            result |= 1 << (i - l);
-        }
+static void print_title(std::ostream& out, std::uint32_t adr, const std::string& tag) {
+    if (tag.empty()) {
+        thread_local char buf_title[25];
+        sprintf(buf_title, "%08x", adr);
+        out.write(buf_title, static_cast<int>(std::string(buf_title).size()));
+        out.write(std::string(13, ' ').c_str(), 13);
+    } else {
+        thread_local char buf_title[MAX_LENGTH];
+        sprintf(buf_title, "%08x %10s: ", adr, tag.c_str());
+        out.write(buf_title, static_cast<int>(std::string(buf_title).size()));
     }
-    return result;
 }
 
-static int get_signed(std::uint32_t value, int l, int r) {
-    int result = 0;
-    if ((value >> r) & 1) {
-        for (int i = l; i < r; i++) {
-            if (!((value >> i) & 1)) {
-                result |= 1 << (i - l);
-            }
-        }
-        return -result - 1;
+static void print_cmd (
+        std::ostream& out,
+        std::uint32_t adr,
+        const std::string& tag,
+        const std::vector<std::string>& args,
+        bool is_load_store = false
+) {
+    print_title(out, adr, tag);
+    auto cmd = format_cmd(args, is_load_store);
+    out.write(cmd.c_str(), static_cast<int>(cmd.size()));
+}
+
+static std::vector<std::string> get_args(
+        const DecodedInsn& insn,
+        std::uint32_t adr,
+        const std::map<std::uint32_t, std::string>& tags
+) {
+    // read only, listings of functions are formatted on several threads at once
+    auto target = [&]() {
+        auto it = tags.find(adr + insn.imm);
+        return it != tags.end() ? it->second : std::to_string(insn.imm);
+    };
+    switch (insn.format) {
+        case Format::NONE: return {};
+        case Format::RS1: return {get_reg(insn.rs1)};
+        case Format::RD_RS2: return {get_reg(insn.rd), get_reg(insn.rs2)};
+        case Format::RD_IMM: return {get_reg(insn.rd), std::to_string(insn.imm)};
+        case Format::RD_RS1_IMM: return {get_reg(insn.rd), get_reg(insn.rs1), std::to_string(insn.imm)};
+        case Format::RD_RS1_RS2: return {get_reg(insn.rd), get_reg(insn.rs1), get_reg(insn.rs2)};
+        case Format::LOAD: return {get_reg(insn.rd), std::to_string(insn.imm), get_reg(insn.rs1)};
+        case Format::STORE: return {get_reg(insn.rs2), std::to_string(insn.imm), get_reg(insn.rs1)};
+        case Format::JUMP: return {target()};
+        case Format::RD_JUMP: return {get_reg(insn.rd), target()};
+        case Format::RS1_JUMP: return {get_reg(insn.rs1), target()};
+        case Format::RS1_RS2_JUMP: return {get_reg(insn.rs1), get_reg(insn.rs2), target()};
+    }
+    return {};
+}
+
+void print_insn(
+        std::ostream& out,
+        std::uint32_t adr,
+        const std::string& tag,
+        const DecodedInsn& insn,
+        const std::map<std::uint32_t, std::string>& tags
+) {
+    if (insn.op == Op::UNKNOWN) {
+        std::string s = "unknown_command\n";
+        out.write(s.c_str(), static_cast<int>(s.size()));
+        return;
     }
-    return static_cast<int>(get_unsigned(value, l, r - 1));
+    auto args = get_args(insn, adr, tags);
+    args.insert(args.begin(), get_op_name(insn.op));
+    print_cmd(out, adr, tag, args, insn.format == Format::LOAD || insn.format == Format::STORE);
 }
 
-static std::string get_reg(std::uint32_t id) {
-    if (id == 0)
-        return "zero";
-    if (id == 1)
-        return "ra";
-    if (id == 2)
-        return "sp";
-    if (id == 3)
-        return "gp";
-    if (id == 4)
-        return "tp";
-    if (id >= 5 && id <= 7)
-        return "t" + std::to_string(id - 5);
-    if (id == 8 || id == 9)
-        return "s" + std::to_string(id - 8);
-    if (id >= 10 && id <= 17)
-        return "a" + std::to_string(id - 10);
-    if (id >= 18 && id <= 27)
-        return "s" + std::to_string(id - 16);
-    if (id >= 28 && id <= 31)
-        return "t" + std::to_string(id - 25);
-    throw std::invalid_argument("unknown register");
+std::string format_insn(const DecodedInsn& insn, std::uint32_t adr, const std::map<std::uint32_t, std::string>& tags) {
+    if (insn.op == Op::UNKNOWN) {
+        return "unknown_command\n";
+    }
+    auto args = get_args(insn, adr, tags);
+    args.insert(args.begin(), get_op_name(insn.op));
+    return format_cmd(args, insn.format == Format::LOAD || insn.format == Format::STORE);
 }
 
-static void parse_text (
-        std::ifstream& in,
-        std::ofstream& out,
-        std::vector<Elf32_section_header>& section_headers,
-        std::map<std::uint32_t, std::string>& tags
+// shorter runs print as they are
+const std::uint32_t MIN_REPEATS = 2;
+
+// number of copies of the `length`-byte command at adr that follow it before limit
+static std::uint32_t count_repeats(const std::vector<char>& text, std::uint32_t adr, std::uint32_t length,
+                                   std::uint32_t limit) {
+    const char* first = text.data() + adr;
+    std::uint32_t next = adr + length;
+#ifdef __SSE2__
+    // 2 and 4 divide 16, so the command repeated over a vector lines up with every 16 bytes of the run
+    char unit[16];
+    for (std::uint32_t i = 0; i < sizeof(unit); i += length) {
+        std::memcpy(unit + i, first, length);
+    }
+    const __m128i pattern = _mm_loadu_si128(reinterpret_cast<const __m128i *>(unit));
+    while (next + 16 <= limit) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + next));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)) != 0xffff) {
+            break;
+        }
+        next += 16;
+    }
+#endif
+    while (next + length <= limit && std::memcmp(first, text.data() + next, length) == 0) {
+        next += length;
+    }
+    return (next - adr) / length - 1;
+}
+
+void parse_text (
+        const std::vector<char>& text,
+        std::ostream& out,
+        const std::map<std::uint32_t, std::string>& tags,
+        std::uint32_t begin,
+        std::uint32_t end,
+        bool collapse_repeats,
+        FormatCache* cache,
+        LineIndex* line_index
 ) {
-    std::size_t text_section_id = find_section(section_headers, TEXT_TYPE);
-    std::uint32_t text_offset = section_headers[text_section_id].sh_offset,
-    text_size = section_headers[text_section_id].sh_size;
-    in.seekg(text_offset);
-
-    while (static_cast<std::uint32_t>(in.tellg()) - text_offset < text_size) {
-        bool is_load_store = false;
-        auto adr = static_cast<std::uint32_t>(in.tellg()) - text_offset;
-        auto tag = (tags.count(adr) ? tags[adr] : "");
-        std::uint32_t cmd32;
-        std::uint16_t cmd16;
-        in.read(reinterpret_cast<char *>(&cmd16), sizeof(cmd16));
-        std::vector<std::string> args;
-        std::string cmd_name;
-        if (get_segment(cmd16, 0, 1) == "00") {
-            std::string type = get_segment(cmd16, 13, 15);
-            if (type == "000") {
-                cmd_name = "c.addi4spn";
-                auto value = (get_unsigned(cmd16, 11, 12) << 4) +
-                        (get_unsigned(cmd16, 7, 10) << 6) +
-                        (get_unsigned(cmd16, 6, 6) << 2) +
-                        (get_unsigned(cmd16, 5, 5) << 3);
-                args = {
-                    get_reg(get_unsigned(cmd16, 2, 4) + 8),
-                    get_reg(2),
-                    std::to_string(value)
-                };
-            } else if (type == "001" || type == "011" || type == "101") {
-                is_load_store = true;
-                if (type == "001") {
-                    cmd_name = "c.fld";
-                } else if (type == "011") {
-                    cmd_name = "c.ld";
-                } else {
-                    cmd_name = "c.fsd";
-                }
-                auto value = (get_unsigned(cmd16, 10, 12) << 3) +
-                        (get_unsigned(cmd16, 5, 6) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 2, 4) + 8),
-                    std::to_string(value),
-                    get_reg(get_unsigned(cmd16, 7, 9) + 8)
-                };
-            } else if (type == "010" || type == "011" || type == "110" || type == "111") {
-                is_load_store = true;
-                if (type == "010") {
-                    cmd_name = "c.lw";
-                } else if (type == "011") {
-                    cmd_name = "c.flw";
-                } else if (type == "110") {
-                    cmd_name = "c.sw";
-                } else {
-                    cmd_name = "c.fsw";
-                }
-                auto value = (get_unsigned(cmd16, 10, 12) << 3) +
-                        (get_unsigned(cmd16, 6, 6) << 2) +
-                        (get_unsigned(cmd16, 5, 5) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 2, 4) + 8),
-                    std::to_string(value),
-                    get_reg(get_unsigned(cmd16, 7, 9) + 8)
-                };
-            }
-        } else if (get_segment(cmd16, 0, 1) == "01") {
-            if (get_segment(cmd16, 2, 15) == std::string(14, '0')) {
-                cmd_name = "c.nop";
-            } else {
-                std::string type = get_segment(cmd16, 13, 15);
-                if (type == "000") {
-                    cmd_name = "c.addi";
-                    args = {
-                        get_reg(get_unsigned(cmd16, 7, 11)),
-                        get_reg(get_unsigned(cmd16, 7, 11)),
-                        std::to_string(get_signed((get_unsigned(cmd16, 12, 12) << 5) +
-                        get_unsigned(cmd16, 2, 6), 0, 5))
-                    };
-                } else if (type == "001") {
-                    cmd_name = "c.jal";
-                    auto uvalue = (get_unsigned(cmd16, 12, 12) << 11) +
-                            (get_unsigned(cmd16, 11, 11) << 4) +
-                            (get_unsigned(cmd16, 9, 10) << 8) +
-                            (get_unsigned(cmd16, 8, 8) << 10) +
-                            (get_unsigned(cmd16, 7, 7) << 6) +
-                            (get_unsigned(cmd16, 6, 6) << 7) +
-                            (get_unsigned(cmd16, 3, 5) << 1) +
-                            (get_unsigned(cmd16, 2, 2) << 5);
-                    auto value = get_signed(uvalue, 0, 11);
-                    if (tags.count(adr + value)) {
-                        args = {tags[adr + value]};
-                    } else {
-                        args = {std::to_string(value)};
-                    }
-                } else if (type == "010") {
-                    cmd_name = "c.li";
-                    args = {
-                        get_reg(get_unsigned(cmd16, 7, 11)),
-                        std::to_string(get_signed((get_unsigned(cmd16, 12, 12) << 5) +
-                        get_unsigned(cmd16, 2, 6), 0, 5))
-                    };
-                } else if (type == "011" && get_unsigned(cmd16, 7, 11) == 2) {
-                    cmd_name = "c.addi16sp";
-                    auto uvalue = (get_unsigned(cmd16, 12, 12) << 9)
-                            + (get_unsigned(cmd16, 6, 6) << 4) +
-                            (get_unsigned(cmd16, 5, 5) << 6) +
-                            (get_unsigned(cmd16, 3, 4) << 7) +
-                            (get_unsigned(cmd16, 2, 2) << 5);
-                    auto value = get_signed(uvalue, 0, 9);
-                    args = {
-                        get_reg(2),
-                        get_reg(2),
-                        std::to_string(value)
-                    };
-                } else if (type == "011") {
-                    cmd_name = "c.lui";
-                    auto value = get_signed((get_unsigned(cmd16, 12, 12) << 17) +
-                                                    (get_unsigned(cmd16, 2, 6) << 12), 0, 17);
-                    args = {
-                        get_reg(get_unsigned(cmd16, 7, 11)),
-                        std::to_string(value)
-                    };
-                } else if (type == "100") {
-                    if (get_segment(cmd16, 10, 11) == "00") {
-                        cmd_name = "c.srli";
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            std::to_string((get_unsigned(cmd16, 12, 12) << 5) +
-                            get_unsigned(cmd16, 2, 6))
-                        };
-                    } else if (get_segment(cmd16, 10, 11) == "01") {
-                        cmd_name = "c.srai";
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            std::to_string((get_unsigned(cmd16, 12, 12) << 5) + get_unsigned(cmd16, 2, 6))
-                        };
-                    } else if (get_segment(cmd16, 10, 11) == "10") {
-                        cmd_name = "c.andi";
-                        auto value = get_signed((get_unsigned(cmd16, 12, 12) << 5) +
-                                get_unsigned(cmd16, 2, 6), 0, 5);
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            std::to_string(value)
-                        };
-                    } else if (get_segment(cmd16, 10, 11) == "11") {
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            get_reg(get_unsigned(cmd16, 7, 9) + 8),
-                            get_reg(get_unsigned(cmd16, 2, 4) + 8)
-                        };
-                        std::string type2 = get_segment(cmd16, 12, 12) + get_segment(cmd16, 5, 6);
-                        if (type2 == "000") {
-                            cmd_name = "c.sub";
-                        } else if (type2 == "001") {
-                            cmd_name = "c.xor";
-                        } else if (type2 == "010") {
-                            cmd_name = "c.or";
-                        } else if (type2 == "011") {
-                            cmd_name = "c.and";
-                        } else if (type2 == "100") {
-                            cmd_name = "c.subw";
-                        } else if (type2 == "101") {
-                            cmd_name = "c.addw";
-                        }
-                    }
-                } else if (type == "101") {
-                    cmd_name = "c.j";
-                    auto uvalue = (get_unsigned(cmd16, 12, 12) << 11) +
-                            (get_unsigned(cmd16, 11, 11) << 4) +
-                            (get_unsigned(cmd16, 9, 10) << 8) +
-                            (get_unsigned(cmd16, 8, 8) << 10) +
-                            (get_unsigned(cmd16, 7, 7) << 6) +
-                            (get_unsigned(cmd16, 6, 6) << 7) +
-                            (get_unsigned(cmd16, 3, 5) << 1) +
-                            (get_unsigned(cmd16, 2, 2) << 5);
-                    auto value = get_signed(uvalue, 0, 11);
-                    if (tags.count(adr + value)) {
-                        args = {tags[adr + value]};
-                    } else {
-                        args = {std::to_string(value)};
-                    }
-                } else if (type == "110" || type == "111") {
-                    if (type == "110") {
-                        cmd_name = "c.beqz";
-                    } else {
-                        cmd_name = "c.bnez";
-                    }
-                    args = {get_reg(get_unsigned(cmd16, 7, 9) + 8)};
-                    auto uvalue = (get_unsigned(cmd16, 12, 12) << 8) +
-                            (get_unsigned(cmd16, 10, 11) << 3) +
-                            (get_unsigned(cmd16, 5, 6) << 6) +
-                            (get_unsigned(cmd16, 3, 4) << 1) +
-                            (get_unsigned(cmd16, 2, 2) << 5);
-                    auto value = get_signed(uvalue, 0, 8);
-                    if (tags.count(adr + value)) {
-                        args.push_back(tags[adr + value]);
-                    } else {
-                        args.push_back(std::to_string(value));
-                    }
-                }
-            }
-        } else if (get_segment(cmd16, 0, 1) == "10") {
-            std::string type = get_segment(cmd16, 13, 15);
-            if (type == "000") {
-                cmd_name = "c.slli";
-                auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
-                        get_unsigned(cmd16, 2, 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 7, 11)),
-                    get_reg(get_unsigned(cmd16, 7, 11)),
-                    std::to_string(uvalue)
-                };
-            } else if (type == "001") {
-                is_load_store = true;
-                cmd_name = "c.fldsp";
-                auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
-                        (get_unsigned(cmd16, 5, 6) << 3) +
-                        (get_unsigned(cmd16, 2, 4) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 7, 11)),
-                    std::to_string(uvalue),
-                    get_reg(2)
-                };
-            } else if (type == "010") {
-                is_load_store = true;
-                cmd_name = "c.lwsp";
-                auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
-                              (get_unsigned(cmd16, 4, 6) << 2) +
-                              (get_unsigned(cmd16, 2, 3) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 7, 11)),
-                    std::to_string(uvalue),
-                    get_reg(2)
-                };
-            } else if (type == "011") {
-                is_load_store = true;
-                cmd_name = "c.flwsp";
-                auto uvalue = (get_unsigned(cmd16, 12, 12) << 5) +
-                              (get_unsigned(cmd16, 4, 6) << 2) +
-                              (get_unsigned(cmd16, 2, 3) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 7, 11)),
-                    std::to_string(uvalue),
-                    get_reg(2)
-                };
-            } else if (type == "100") {
-                if (get_segment(cmd16, 2, 6) != "00000") {
-                    if (get_segment(cmd16, 12, 12) == "1") {
-                        cmd_name = "c.add";
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 11)),
-                            get_reg(get_unsigned(cmd16, 7, 11)),
-                            get_reg(get_unsigned(cmd16, 2, 6))
-                        };
-                    } else {
-                        cmd_name = "c.mv";
-                        args = {
-                            get_reg(get_unsigned(cmd16, 7, 11)),
-                            get_reg(get_unsigned(cmd16, 2, 6))
-                        };
-                    }
-                } else {
-                    if (get_segment(cmd16, 7, 15) == "100100000") {
-                        cmd_name = "c.ebreak";
-                    } else {
-                        args = {get_reg(get_unsigned(cmd16, 7, 11))};
-                        if (get_segment(cmd16, 12, 12) == "0") {
-                            cmd_name = "c.jr";
-                        } else {
-                            cmd_name = "c.jalr";
-                        }
-                    }
-                }
-            } else if (type == "101") {
-                is_load_store = true;
-                cmd_name = "c.fsdsp";
-                auto uvalue = (get_unsigned(cmd16, 10, 12) << 3) +
-                        (get_unsigned(cmd16, 7, 9) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 2, 6)),
-                    std::to_string(uvalue),
-                    get_reg(2)
-                };
-            } else {
-                is_load_store = true;
-                if (type == "110") {
-                    cmd_name = "c.swsp";
-                } else {
-                    cmd_name = "c.fswsp";
-                }
-                auto uvalue = (get_unsigned(cmd16, 9, 12) << 2) +
-                              (get_unsigned(cmd16, 7, 8) << 6);
-                args = {
-                    get_reg(get_unsigned(cmd16, 2, 6)),
-                    std::to_string(uvalue),
-                    get_reg(2)
-                };
+    std::uint32_t printed = 0;
+    for (std::uint32_t adr = begin; adr < end; printed++) {
+        auto insn = decode(get_word(text, adr));
+        auto it = tags.find(adr);
+        if (line_index != nullptr && (it != tags.end() || printed % line_index->step == 0)) {
+            auto offset = out.tellp();
+            if (offset < 0) {
+                throw std::invalid_argument("line index needs an output file that supports seeking");
             }
+            line_index->entries.push_back({adr, static_cast<std::uint64_t>(offset)});
         }
-        else if (get_segment(cmd16, 0, 6) == "0110111") {
-            cmd32 = get_cmd32(in, cmd16);
-            args = std::vector<std::string>({
-                get_reg(get_unsigned(cmd32, 7, 11)),
-                std::to_string(get_signed((get_unsigned(cmd32, 12, 31) << 12), 0, 31))
-            });
-            cmd_name = "lui";
-        } else if (get_segment(cmd16, 0, 6) == "0010111") {
-            cmd32 = get_cmd32(in, cmd16);
-            auto value = get_signed((get_unsigned(cmd32, 12, 31) << 12), 0, 31);
-            args = std::vector<std::string>({
-                get_reg(get_unsigned(cmd32, 7, 11)),
-                std::to_string(value)
-            });
-            cmd_name = "auipc";
-        } else if (get_segment(cmd16, 0, 6) == "0010011") {
-            cmd32 = get_cmd32(in, cmd16);
-            std::string type = get_segment(cmd32, 12, 14);
-            if (type != "001" && type != "101") {
-                if (type == "000") {
-                    cmd_name = "addi";
-                } else if (type == "010") {
-                    cmd_name = "slti";
-                } else if (type == "011") {
-                    cmd_name = "sltiu";
-                } else if (type == "100") {
-                    cmd_name = "xori";
-                } else if (type == "110") {
-                    cmd_name = "ori";
-                } else if (type == "111") {
-                    cmd_name = "andi";
-                }
-                args = std::vector<std::string>({
-                     get_reg(get_unsigned(cmd32, 7, 11)),
-                     get_reg(get_unsigned(cmd32, 15, 19)),
-                     std::to_string(get_signed((get_unsigned(cmd32, 20, 31)), 0, 11))
-                });
-            } else {
-                args = std::vector<std::string>({
-                    get_reg(get_unsigned(cmd32, 7, 11)),
-                    get_reg(get_unsigned(cmd32, 15, 19)),
-                    std::to_string((get_unsigned(cmd32, 20, 24)))
-                });
-                if (type == "001") {
-                    cmd_name = "slli";
-                } else {
-                    if (get_segment(cmd32, 30, 30) == "0") {
-                        cmd_name = "srli";
-                    } else {
-                        cmd_name = "srai";
-                    }
-                }
-            }
-        } else if (get_segment(cmd16, 0, 6) == "0110011") {
-            cmd32 = get_cmd32(in, cmd16);
-            if (get_segment(cmd32, 25, 26) == "00") {
-                std::string type = get_segment(cmd32, 27, 31) + get_segment(cmd32, 12, 14);
-                args = {
-                    get_reg(get_unsigned(cmd32, 7, 11)),
-                    get_reg(get_unsigned(cmd32, 15, 19)),
-                    get_reg(get_unsigned(cmd32, 20, 24))
-                };
-                if (type == "00000000") {
-                    cmd_name = "add";
-                } else if (type == "01000000") {
-                    cmd_name = "sub";
-                } else if (type == "00000001") {
-                    cmd_name = "sll";
-                } else if (type == "00000010") {
-                    cmd_name = "slt";
-                } else if (type == "00000011") {
-                    cmd_name = "sltu";
-                } else if (type == "00000100") {
-                    cmd_name = "xor";
-                } else if (type == "00000101") {
-                    cmd_name = "srl";
-                } else if (type == "01000101") {
-                    cmd_name = "sra";
-                } else if (type == "00000110") {
-                    cmd_name = "or";
-                } else if (type == "00000111") {
-                    cmd_name = "and";
-                }
-            } else if (get_segment(cmd32, 25, 26) == "01") {
-                std::string type = get_segment(cmd32, 12, 14);
-                args = {
-                    get_reg(get_unsigned(cmd32, 7, 11)),
-                    get_reg(get_unsigned(cmd32, 15, 19)),
-                    get_reg(get_unsigned(cmd32, 20, 24))
-                };
-                if (type == "000") {
-                    cmd_name = "mul";
-                } else if (type == "001") {
-                    cmd_name = "mulh";
-                } else if (type == "010") {
-                    cmd_name = "mulhsu";
-                } else if (type == "011") {
-                    cmd_name = "mulhu";
-                } else if (type == "100") {
-                    cmd_name = "div";
-                } else if (type == "101") {
-                    cmd_name = "divu";
-                } else if (type == "110") {
-                    cmd_name = "rem";
-                } else if (type == "111") {
-                    cmd_name = "remu";
-                }
-            }
-        } else if (get_segment(cmd16, 0, 6) == "0000011") {
-            is_load_store = true;
-            cmd32 = get_cmd32(in, cmd16);
-            std::string type = get_segment(cmd32, 12, 14);
-            args = {
-                get_reg(get_unsigned(cmd32, 7, 11)),
-                std::to_string(get_signed(cmd32, 20, 31)),
-                get_reg(get_unsigned(cmd32, 15, 19))
-            };
-            if (type == "000") {
-                cmd_name = "lb";
-            } else if (type == "001") {
-                cmd_name = "lh";
-            } else if (type == "010") {
-                cmd_name = "lw";
-            } else if (type == "100") {
-                cmd_name = "lbu";
-            } else if (type == "101") {
-                cmd_name = "lhu";
-            }
-        } else if (get_segment(cmd16, 0, 6) == "0100011") {
-            cmd32 = get_cmd32(in, cmd16);
-            std::string type = get_segment(cmd32, 12, 14);
-            args = {
-                get_reg(get_unsigned(cmd32, 20, 24)),
-                std::to_string(get_signed((get_unsigned(cmd32, 25, 31) << 5) + get_unsigned(cmd32, 7, 11), 0, 11)),
-                get_reg(get_unsigned(cmd32, 15, 19))
-            };
-            is_load_store = true;
-            if (type == "000") {
-                cmd_name = "sb";
-            } else if (type == "001") {
-                cmd_name = "sh";
-            } else if (type == "010") {
-                cmd_name = "sw";
-            }
-        } else if (get_segment(cmd16, 0, 6) == "1101111") {
-            cmd32 = get_cmd32(in, cmd16);
-            cmd_name = "jal";
-            args = {get_reg(get_signed(cmd32, 7, 11))};
-            auto uvalue = (get_unsigned(cmd32, 31, 31) << 20) +
-                    (get_unsigned(cmd32, 21, 30) << 1) +
-                    (get_unsigned(cmd32, 20, 20) << 11) +
-                    (get_unsigned(cmd32, 12, 19) << 12);
-            auto value = get_signed(uvalue, 0, 20);
-            if (tags.count(adr + value)) {
-                args.push_back(tags[adr + value]);
+        if (cache != nullptr && insn.op != Op::UNKNOWN && !has_target(insn)) {
+            // Fibonacci hashing spreads the few varying operand bits over the whole index
+            auto& entry = cache->entries[(insn.raw * 0x9e3779b1u) >> 20];
+            cache->lookups++;
+            if (entry.valid && entry.raw == insn.raw) {
+                cache->hits++;
             } else {
-                args.push_back(std::to_string(value));
+                entry.valid = true;
+                entry.raw = insn.raw;
+                entry.text = format_insn(insn, adr, tags);
             }
-        } else if (get_segment(cmd16, 0, 6) == "1100111") {
-            cmd32 = get_cmd32(in, cmd16);
-            cmd_name = "jalr";
-            args = {
-                get_reg(get_unsigned(cmd32, 7, 11)),
-                get_reg(get_unsigned(cmd32, 15, 19)),
-            };
-            auto value = get_signed(get_unsigned(cmd32, 20, 31), 0, 11);
-            args.push_back(std::to_string(value));
-        } else if (get_segment(cmd16, 0, 6) == "1100011") {
-            cmd32 = get_cmd32(in, cmd16);
-            args = {
-                get_reg(get_unsigned(cmd32, 15, 19)),
-                get_reg(get_unsigned(cmd32, 20, 24))
-            };
-            std::string type = get_segment(cmd32, 12, 14);
-            if (type == "000") {
-                cmd_name = "beq";
-            } else if (type == "001") {
-                cmd_name = "bne";
-            } else if (type == "100") {
-                cmd_name = "blt";
-            } else if (type == "101") {
-                cmd_name = "bge";
-            } else if (type == "110") {
-                cmd_name = "bltu";
-            } else if (type == "111") {
-                cmd_name = "bgeu";
-            }
-            auto uvalue = (get_unsigned(cmd32, 31, 31) << 12) +
-                    (get_unsigned(cmd32, 25, 30) << 5) +
-                    (get_unsigned(cmd32, 8, 11) << 1) +
-                    (get_unsigned(cmd32, 7, 7) << 11);
-            auto value = get_signed(uvalue, 0, 12);
-            if (tags.count(adr + value)) {
-                args.push_back(tags[adr + value]);
-            } else {
-                args.push_back(std::to_string(value));
+            print_title(out, adr, it == tags.end() ? "" : it->second);
+            out.write(entry.text.data(), static_cast<int>(entry.text.size()));
+        } else {
+            print_insn(out, adr, it == tags.end() ? "" : it->second, insn, tags);
+        }
+        if (collapse_repeats) {
+            // runs stop before the next tag so that every label still gets its own line
+            auto next_tag = tags.upper_bound(adr);
+            auto limit = std::min<std::uint32_t>(text.size(), next_tag == tags.end() ? end : std::min(end, next_tag->first));
+            auto repeats = count_repeats(text, adr, insn.length, limit);
+            if (repeats >= MIN_REPEATS) {
+                thread_local char buf[64];
+                snprintf(buf, sizeof(buf), "%08x             ... repeated %u times\n", adr + insn.length, repeats);
+                out.write(buf, static_cast<int>(strlen(buf)));
+                adr += repeats * insn.length;
             }
         }
+        adr += insn.length;
+    }
+}
 
-        if (cmd_name.empty()) {
-            std::string s = "unknown_command\n";
-            out.write(s.c_str(), static_cast<int>(s.size()));
-        } else {
-            args.insert(args.begin(), cmd_name);
-            print_cmd(out, adr, tag, args, is_load_store);
+static std::vector<char> read_raw_section(std::istream& in, const Elf32_section_header& s_header) {
+    std::vector<char> data(s_header.sh_size);
+    in.seekg(s_header.sh_offset);
+    in.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return data;
+}
+
+static std::vector<char> decompress_section(const std::vector<char>& raw) {
+    Elf32_Chdr header;
+    if (raw.size() < sizeof(header)) {
+        throw std::invalid_argument("compressed section is shorter than its header");
+    }
+    std::memcpy(&header, raw.data(), sizeof(header));
+    if (header.ch_type != ELFCOMPRESS_ZLIB && header.ch_type != ELFCOMPRESS_ZSTD) {
+        throw std::invalid_argument("unknown section compression " + std::to_string(header.ch_type));
+    }
+    return decompress(raw.data() + sizeof(header), raw.size() - sizeof(header), header.ch_size,
+                      header.ch_type == ELFCOMPRESS_ZSTD);
+}
+
+std::vector<char> read_section(std::istream& in, const Elf32_section_header& s_header) {
+    auto data = read_raw_section(in, s_header);
+    return (s_header.sh_flags & SHF_COMPRESSED) ? decompress_section(data) : data;
+}
+
+std::vector<std::vector<char>> read_sections(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& s_headers,
+        unsigned jobs
+) {
+    std::vector<std::vector<char>> sections;
+    for (const auto& s_header : s_headers) {
+        sections.push_back(read_raw_section(in, s_header));
+    }
+    parallel_for(sections.size(), jobs, [&](std::size_t i) {
+        if (s_headers[i].sh_flags & SHF_COMPRESSED) {
+            sections[i] = decompress_section(sections[i]);
+        }
+    });
+    return sections;
+}
+
+static std::pair<std::uint32_t, std::uint32_t> get_text_bounds(const std::vector<char>& text, const TextRange& range) {
+    std::uint32_t text_size = text.size();
+    if (range.is_full()) {
+        return {0, text_size};
+    }
+    InstructionIndex index(text);
+    std::uint32_t begin, end;
+    if (range.by_ordinal) {
+        begin = (range.begin < index.size() ? index.select(range.begin) : text_size);
+        end = (range.end < index.size() ? index.select(range.end) : text_size);
+    } else {
+        std::uint32_t indexed_size = text_size / 2 * 2;
+        begin = (range.begin < indexed_size ? index.select(index.rank(range.begin)) : text_size);
+        if (range.begin == range.end) {
+            // rounding would widen an empty range to the command around begin
+            return {begin, begin};
+        }
+        end = text_size;
+        if (range.end < indexed_size && range.end > 0 && index.rank(range.end - 1) + 1 < index.size()) {
+            end = index.select(index.rank(range.end - 1) + 1);
         }
     }
+    return {begin, std::max(begin, end)};
 }
 
-void parse(std::ifstream& in, std::ofstream& out) {
+ELF32_header read_file_header(std::istream& in) {
     ELF32_header file_header;
+    in.seekg(0);
     in.read(reinterpret_cast<char *>(&file_header), sizeof(file_header));
     if (file_header.e_ident[1] != 'E' || file_header.e_ident[2] != 'L' || file_header.e_ident[3] != 'F') {
         throw std::invalid_argument("this is not a ELF file");
     }
-    std::vector<Elf32_section_header> section_headers(file_header.e_shnum);
+    return file_header;
+}
+
+std::vector<Elf32_program_header> read_program_headers(std::istream& in) {
+    auto file_header = read_file_header(in);
+    std::vector<Elf32_program_header> program_headers(file_header.e_phoff != 0 ? file_header.e_phnum : 0);
+    in.seekg(file_header.e_phoff);
+    for (auto& p_header : program_headers) {
+        in.read(reinterpret_cast<char *>(&p_header), sizeof(p_header));
+    }
+    return program_headers;
+}
+
+std::vector<Elf32_section_header> read_section_headers(std::istream& in) {
+    auto file_header = read_file_header(in);
+    if (file_header.e_shoff == 0) {
+        return std::vector<Elf32_section_header>();
+    }
+    std::uint32_t count = file_header.e_shnum;
     in.seekg(file_header.e_shoff);
-    for (auto& s_header : section_headers) {
-        in.read(reinterpret_cast<char *>(&s_header), sizeof(s_header));
-    }
-    auto tags = calc_tags(in, section_headers);
-    out.write(".text\n", 6);
-    parse_text(in, out, section_headers, tags);
-    out.write("\n.symtab\n", 9);
-    parse_symtab(in, out, section_headers);
+    if (count == 0) {
+        Elf32_section_header first;
+        in.read(reinterpret_cast<char *>(&first), sizeof(first));
+        count = first.sh_size;
+        in.seekg(file_header.e_shoff);
+    }
+    std::vector<Elf32_section_header> section_headers(count);
+    in.read(reinterpret_cast<char *>(section_headers.data()), count * sizeof(Elf32_section_header));
+    if (!in) {
+        throw std::invalid_argument("section header table is outside of the file");
+    }
+    return section_headers;
+}
+
+// one "address offset [tag]" line per entry, in address order, so that viewers can binary search it
+static void write_line_index(
+        const std::string& file_name,
+        const LineIndex& line_index,
+        const std::map<std::uint32_t, std::string>& tags
+) {
+    std::ofstream out(file_name);
+    if (!out) {
+        throw std::invalid_argument("can't open line index file " + file_name);
+    }
+    out << "# address output-offset [symbol], every " << line_index.step << " commands and at every symbol\n";
+    char buf[32];
+    for (const auto& entry : line_index.entries) {
+        snprintf(buf, sizeof(buf), "%08x %llu", entry.first, static_cast<unsigned long long>(entry.second));
+        out << buf;
+        auto it = tags.find(entry.first);
+        if (it != tags.end()) {
+            out << ' ' << it->second;
+        }
+        out << '\n';
+    }
+}
+
+void parse(std::istream& in, std::ostream& out, const Options& options, FormatCache* cache) {
+    auto section_headers = read_section_headers(in);
+    if (options.print_text) {
+        FormatCache local_cache;
+        if (cache == nullptr) {
+            cache = &local_cache;
+        }
+        auto tags = calc_tags(in, section_headers);
+        out.write(".text\n", 6);
+        auto text = read_section(in, section_headers[find_section(section_headers, TEXT_TYPE)]);
+        auto bounds = get_text_bounds(text, options.range);
+        LineIndex line_index;
+        line_index.step = options.line_index_step;
+        parse_text(text, out, tags, bounds.first, bounds.second, options.collapse_repeats, cache,
+                   options.line_index.empty() ? nullptr : &line_index);
+        if (!options.line_index.empty()) {
+            write_line_index(options.line_index, line_index, tags);
+        }
+    }
+    if (options.print_symtab) {
+        if (options.print_text) {
+            out.write("\n", 1);
+        }
+        out.write(".symtab\n", 8);
+        parse_symtab(in, out, section_headers, options);
+    }
 }
 
 }
\ No newline at end of file
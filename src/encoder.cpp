@@ -0,0 +1,189 @@
+#include "encoder.h"
+#include "code.h"
+#include "parallel.h"
+#include <array>
+#include <cstdio>
+#include <ostream>
+
+namespace Parser {
+
+// bits [l, r] of value moved to bit `to`
+static std::uint32_t put(std::int32_t value, int l, int r, int to) {
+    auto width = r - l + 1;
+    return ((static_cast<std::uint32_t>(value) >> l) & ((1u << width) - 1)) << to;
+}
+
+// registers x8-x15 of the three-bit fields
+static std::uint32_t put_short_reg(std::uint32_t reg, int to) {
+    return ((reg - 8) & 0x7) << to;
+}
+
+static std::uint32_t get_match(Op op) {
+    // a magic static, so that verify_encoding threads can build it concurrently
+    static const auto matches = [] {
+        std::array<std::uint32_t, static_cast<std::size_t>(Op::COUNT)> result{};
+        for (const auto& pattern : get_patterns()) {
+            result[static_cast<std::size_t>(pattern.op)] = pattern.match;
+        }
+        return result;
+    }();
+    return matches[static_cast<std::size_t>(op)];
+}
+
+static std::uint32_t encode_cj_offset(std::int32_t imm) {
+    return put(imm, 11, 11, 12) | put(imm, 4, 4, 11) | put(imm, 8, 9, 9) | put(imm, 10, 10, 8) |
+            put(imm, 6, 6, 7) | put(imm, 7, 7, 6) | put(imm, 1, 3, 3) | put(imm, 5, 5, 2);
+}
+
+static std::uint32_t encode_operands(const DecodedInsn& insn) {
+    auto rd = insn.rd, rs1 = insn.rs1, rs2 = insn.rs2;
+    auto imm = insn.imm;
+    switch (insn.op) {
+        case Op::C_ADDI4SPN:
+            return put_short_reg(rd, 2) | put(imm, 4, 5, 11) | put(imm, 6, 9, 7) | put(imm, 2, 2, 6) | put(imm, 3, 3, 5);
+        case Op::C_FLD:
+        case Op::C_LD:
+            return put_short_reg(rd, 2) | put_short_reg(rs1, 7) | put(imm, 3, 5, 10) | put(imm, 6, 7, 5);
+        case Op::C_FSD:
+            return put_short_reg(rs2, 2) | put_short_reg(rs1, 7) | put(imm, 3, 5, 10) | put(imm, 6, 7, 5);
+        case Op::C_LW:
+            return put_short_reg(rd, 2) | put_short_reg(rs1, 7) | put(imm, 3, 5, 10) | put(imm, 2, 2, 6) | put(imm, 6, 6, 5);
+        case Op::C_SW:
+        case Op::C_FSW:
+            return put_short_reg(rs2, 2) | put_short_reg(rs1, 7) | put(imm, 3, 5, 10) | put(imm, 2, 2, 6) | put(imm, 6, 6, 5);
+        case Op::C_NOP:
+        case Op::C_EBREAK:
+            return 0;
+        case Op::C_ADDI:
+        case Op::C_LI:
+            return (rd << 7) | put(imm, 5, 5, 12) | put(imm, 0, 4, 2);
+        case Op::C_JAL:
+        case Op::C_J:
+            return encode_cj_offset(imm);
+        case Op::C_ADDI16SP:
+            return put(imm, 9, 9, 12) | put(imm, 4, 4, 6) | put(imm, 6, 6, 5) | put(imm, 7, 8, 3) | put(imm, 5, 5, 2);
+        case Op::C_LUI:
+            return (rd << 7) | put(imm, 17, 17, 12) | put(imm, 12, 16, 2);
+        case Op::C_SRLI:
+        case Op::C_SRAI:
+        case Op::C_ANDI:
+            return put_short_reg(rd, 7) | put(imm, 5, 5, 12) | put(imm, 0, 4, 2);
+        case Op::C_SUB:
+        case Op::C_XOR:
+        case Op::C_OR:
+        case Op::C_AND:
+        case Op::C_SUBW:
+        case Op::C_ADDW:
+            return put_short_reg(rd, 7) | put_short_reg(rs2, 2);
+        case Op::C_BEQZ:
+        case Op::C_BNEZ:
+            return put_short_reg(rs1, 7) | put(imm, 8, 8, 12) | put(imm, 3, 4, 10) | put(imm, 6, 7, 5) |
+                    put(imm, 1, 2, 3) | put(imm, 5, 5, 2);
+        case Op::C_SLLI:
+            return (rd << 7) | put(imm, 5, 5, 12) | put(imm, 0, 4, 2);
+        case Op::C_FLDSP:
+            return (rd << 7) | put(imm, 5, 5, 12) | put(imm, 3, 4, 5) | put(imm, 6, 8, 2);
+        case Op::C_LWSP:
+        case Op::C_FLWSP:
+            return (rd << 7) | put(imm, 5, 5, 12) | put(imm, 2, 4, 4) | put(imm, 6, 7, 2);
+        case Op::C_ADD:
+        case Op::C_MV:
+            return (rd << 7) | (rs2 << 2);
+        case Op::C_JR:
+        case Op::C_JALR:
+            return rs1 << 7;
+        case Op::C_FSDSP:
+            return (rs2 << 2) | put(imm, 3, 5, 10) | put(imm, 6, 8, 7);
+        case Op::C_SWSP:
+        case Op::C_FSWSP:
+            return (rs2 << 2) | put(imm, 2, 5, 9) | put(imm, 6, 7, 7);
+        case Op::LUI:
+        case Op::AUIPC:
+            return (rd << 7) | put(imm, 12, 31, 12);
+        case Op::SLLI:
+        case Op::SRLI:
+        case Op::SRAI:
+            return (rd << 7) | (rs1 << 15) | put(imm, 0, 4, 20);
+        case Op::LB:
+        case Op::LH:
+        case Op::LW:
+        case Op::LBU:
+        case Op::LHU:
+        case Op::ADDI:
+        case Op::SLTI:
+        case Op::SLTIU:
+        case Op::XORI:
+        case Op::ORI:
+        case Op::ANDI:
+        case Op::JALR:
+            return (rd << 7) | (rs1 << 15) | put(imm, 0, 11, 20);
+        case Op::SB:
+        case Op::SH:
+        case Op::SW:
+            return (rs1 << 15) | (rs2 << 20) | put(imm, 0, 4, 7) | put(imm, 5, 11, 25);
+        case Op::JAL:
+            return (rd << 7) | put(imm, 20, 20, 31) | put(imm, 1, 10, 21) | put(imm, 11, 11, 20) | put(imm, 12, 19, 12);
+        case Op::BEQ:
+        case Op::BNE:
+        case Op::BLT:
+        case Op::BGE:
+        case Op::BLTU:
+        case Op::BGEU:
+            return (rs1 << 15) | (rs2 << 20) | put(imm, 12, 12, 31) | put(imm, 5, 10, 25) | put(imm, 1, 4, 8) |
+                    put(imm, 11, 11, 7);
+        default:
+            // register-register commands
+            return (rd << 7) | (rs1 << 15) | (rs2 << 20);
+    }
+}
+
+std::uint32_t encode(const DecodedInsn& insn) {
+    if (insn.op == Op::UNKNOWN) {
+        return insn.raw;
+    }
+    return get_match(insn.op) | encode_operands(insn);
+}
+
+void verify_encoding(std::istream& in, std::ostream& out, unsigned jobs) {
+    auto section_headers = read_section_headers(in);
+    auto code = load_code(in, section_headers, jobs);
+
+    std::vector<std::string> reports(code.size());
+    std::vector<std::uint64_t> checked(code.size(), 0), unknown(code.size(), 0), mismatches(code.size(), 0);
+    parallel_for(code.size(), jobs, [&](std::size_t s) {
+        const auto& section = code[s];
+        std::map<std::uint32_t, std::string> no_tags;
+        for (std::uint32_t ordinal = 0; ordinal < section.index.size(); ordinal++) {
+            auto offset = section.index.select(ordinal);
+            auto insn = decode(get_word(section.data, offset));
+            if (insn.op == Op::UNKNOWN) {
+                unknown[s]++;
+                continue;
+            }
+            checked[s]++;
+            auto encoded = encode(insn);
+            if (encoded != insn.raw) {
+                mismatches[s]++;
+                char buf[64];
+                snprintf(buf, sizeof(buf), "%08x: 0x%0*x encoded as 0x%0*x  ", section.address + offset,
+                         insn.length * 2, insn.raw, insn.length * 2, encoded);
+                reports[s] += buf + describe_insn(insn, section.address + offset, no_tags);
+            }
+        }
+    });
+
+    std::uint64_t total_checked = 0, total_unknown = 0, total_mismatches = 0;
+    for (std::size_t s = 0; s < code.size(); s++) {
+        out << reports[s];
+        total_checked += checked[s];
+        total_unknown += unknown[s];
+        total_mismatches += mismatches[s];
+    }
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%llu commands re-encoded, %llu mismatches, %llu unknown commands skipped\n",
+             static_cast<unsigned long long>(total_checked), static_cast<unsigned long long>(total_mismatches),
+             static_cast<unsigned long long>(total_unknown));
+    out << buf;
+}
+
+}
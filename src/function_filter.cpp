@@ -0,0 +1,114 @@
+#include "function_filter.h"
+#include "code.h"
+#include "parallel.h"
+#include <regex>
+#include <sstream>
+
+namespace Parser {
+
+// matches name[0] against the set starting at pattern[p] == '[', moves p past the set;
+// returns false with p unchanged for an unterminated set, which then matches '[' literally
+static bool match_set(const std::string& pattern, std::size_t& p, char c, bool& matched) {
+    auto i = p + 1;
+    bool negate = i < pattern.size() && pattern[i] == '!';
+    if (negate) {
+        i++;
+    }
+    matched = false;
+    // a ']' right after the opening bracket is a member, not the end of the set
+    for (auto first = i; i < pattern.size() && (pattern[i] != ']' || i == first); i++) {
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            matched |= (pattern[i] <= c && c <= pattern[i + 2]);
+            i += 2;
+        } else {
+            matched |= (pattern[i] == c);
+        }
+    }
+    if (i >= pattern.size()) {
+        return false;
+    }
+    matched ^= negate;
+    p = i + 1;
+    return true;
+}
+
+bool match_glob(const std::string& pattern, const std::string& name) {
+    // on a mismatch the last '*' takes one more character and matching resumes after it
+    std::size_t p = 0, n = 0, star = std::string::npos, star_n = 0;
+    while (n < name.size()) {
+        bool matched = false;
+        auto next = p;
+        if (p < pattern.size()) {
+            if (pattern[p] == '*') {
+                star = ++p;
+                star_n = n;
+                continue;
+            }
+            if (pattern[p] != '[' || !match_set(pattern, next, name[n], matched)) {
+                matched = (pattern[p] == '?' || pattern[p] == name[n]);
+                next = p + 1;
+            }
+        }
+        if (matched) {
+            p = next;
+            n++;
+        } else if (star != std::string::npos) {
+            p = star;
+            n = ++star_n;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+void disassemble_functions(std::istream& in, std::ostream& out, const Options& options) {
+    auto section_headers = read_section_headers(in);
+    auto tags = calc_tags(in, section_headers);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, options.jobs);
+
+    std::regex regex;
+    if (options.functions_regex) {
+        try {
+            regex = std::regex(options.functions);
+        } catch (const std::regex_error& e) {
+            throw std::invalid_argument("wrong function regex " + options.functions + ": " + e.what());
+        }
+    }
+    std::vector<std::size_t> matched;
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        bool match = (options.functions_regex ? std::regex_match(functions[i].name, regex)
+                                              : match_glob(options.functions, functions[i].name));
+        if (match && find_function_code(code, functions[i]) != nullptr) {
+            matched.push_back(i);
+        }
+    }
+
+    std::vector<std::string> listings(matched.size());
+    parallel_for(matched.size(), options.jobs, [&](std::size_t m) {
+        auto i = matched[m];
+        auto section = find_function_code(code, functions[i]);
+        auto end = get_function_end(functions, i, *section);
+        std::ostringstream listing;
+        for (auto adr = functions[i].address; adr < end;) {
+            auto insn = decode(get_word(section->data, adr - section->address));
+            // tags are keyed by address only, functions of other sections may share it
+            auto it = tags.find(adr);
+            std::string tag = (adr == functions[i].address ? functions[i].name : it == tags.end() ? "" : it->second);
+            print_insn(listing, adr, tag, insn, tags);
+            adr += insn.length;
+        }
+        listings[m] = listing.str();
+    });
+
+    out << ".text\n";
+    for (std::size_t m = 0; m < matched.size(); m++) {
+        out << (m == 0 ? "" : "\n") << listings[m];
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#include "instruction_index.h"
+#include <stdexcept>
+
+namespace Parser {
+
+static int popcount(std::uint64_t x) {
+    return __builtin_popcountll(x);
+}
+
+InstructionIndex::InstructionIndex(const std::vector<char>& code) {
+    std::uint32_t halfwords = code.size() / 2;
+    bits.assign((halfwords + 63) / 64, 0);
+
+    for (std::uint32_t i = 0; i < halfwords; count++) {
+        bits[i / 64] |= std::uint64_t(1) << (i % 64);
+        if (count % SELECT_SAMPLE == 0) {
+            select_hint.push_back(i / 64);
+        }
+        // the two low bits of the first halfword tell 16-bit (00, 01, 10) from 32-bit (11) encodings
+        i += ((code[2 * i] & 0x3) == 0x3 ? 2 : 1);
+    }
+
+    std::uint32_t ones = 0;
+    for (std::size_t w = 0; w < bits.size(); w++) {
+        if (w % WORDS_PER_BLOCK == 0) {
+            block_rank.push_back(ones);
+        }
+        ones += popcount(bits[w]);
+    }
+}
+
+std::uint32_t InstructionIndex::ones_before(std::uint32_t halfword) const {
+    if (halfword >= bits.size() * 64) {
+        return count;
+    }
+    std::uint32_t word = halfword / 64;
+    std::uint32_t block = word / WORDS_PER_BLOCK;
+    std::uint32_t result = block_rank[block];
+    for (std::uint32_t w = block * WORDS_PER_BLOCK; w < word; w++) {
+        result += popcount(bits[w]);
+    }
+    if (halfword % 64 != 0) {
+        result += popcount(bits[word] & ((std::uint64_t(1) << (halfword % 64)) - 1));
+    }
+    return result;
+}
+
+std::uint32_t InstructionIndex::rank(std::uint32_t offset) const {
+    if (offset / 2 >= bits.size() * 64) {
+        throw std::invalid_argument("offset is outside of the indexed section");
+    }
+    return ones_before(offset / 2 + 1) - 1;
+}
+
+std::uint32_t InstructionIndex::select(std::uint32_t ordinal) const {
+    if (ordinal >= count) {
+        throw std::invalid_argument("instruction ordinal is outside of the indexed section");
+    }
+    // every instruction is 2 or 4 bytes long, so the scan from the sampled word is at most
+    // 2 * SELECT_SAMPLE halfwords long
+    std::uint32_t word = select_hint[ordinal / SELECT_SAMPLE];
+    std::uint32_t left = ordinal - ones_before(word * 64);
+    while (static_cast<std::uint32_t>(popcount(bits[word])) <= left) {
+        left -= popcount(bits[word]);
+        word++;
+    }
+    std::uint64_t x = bits[word];
+    for (; left > 0; left--) {
+        x &= x - 1;
+    }
+    return 2 * (word * 64 + __builtin_ctzll(x));
+}
+
+bool InstructionIndex::is_start(std::uint32_t offset) const {
+    return offset % 2 == 0 && offset / 2 < bits.size() * 64 && (bits[offset / 128] >> (offset / 2 % 64)) & 1;
+}
+
+}
@@ -1,24 +1,39 @@
-#include "elf_parser.h"
+#include "driver.h"
+#include "watch.h"
+#include "worker.h"
 #include <iostream>
 #include <stdexcept>
-#include <fstream>
+#include <string>
+#include <vector>
 
 const int ARGUMENTS_COUNT = 3;
 
 int main(int argc, char * argv[]) {
     try {
+        if (argc > 1 && std::string(argv[1]).rfind("--worker", 0) == 0) {
+            auto options = Parser::parse_options(argc, argv, 1);
+            Parser::run_worker(std::cin, std::cout, options);
+            return 0;
+        }
+        if (argc > 2 && std::string(argv[1]).rfind("--sweep", 0) == 0) {
+            // hw3 --sweep[=A:B] output [options]: there is no input file
+            std::vector<std::string> args(argv + 3, argv + argc);
+            args.push_back(argv[1]);
+            Parser::run_sweep(argv[2], Parser::parse_options(args));
+            return 0;
+        }
         if (argc < ARGUMENTS_COUNT) {
             throw std::invalid_argument("wrong number of arguments.");
         }
         std::string input_file_name = std::string(argv[1]),
                     output_file_name = std::string(argv[2]);
 
-        std::ifstream in(input_file_name, std::ios::binary);
-        in.exceptions(std::ifstream::failbit | std::ifstream::eofbit);
-
-        std::ofstream out(output_file_name);
+        auto options = Parser::parse_options(argc, argv, ARGUMENTS_COUNT);
+        if (options.watch) {
+            Parser::watch(input_file_name, output_file_name, options);
+        }
 
-        Parser::parse(in, out);
+        Parser::run(input_file_name, output_file_name, options);
     } catch (const std::invalid_argument& e) {
         std::cout << "Error: " << e.what() << std::endl;
         return 1;
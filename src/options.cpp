@@ -0,0 +1,198 @@
+#include "options.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <thread>
+
+namespace Parser {
+
+static std::uint32_t get_number(const std::string& s) {
+    std::size_t pos;
+    unsigned long value;
+    try {
+        value = std::stoul(s, &pos, 0);
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument("wrong number in options: " + s);
+    }
+    if (pos != s.size() || value > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("wrong number in options: " + s);
+    }
+    return static_cast<std::uint32_t>(value);
+}
+
+static std::vector<std::string> split_list(const std::string& s) {
+    std::vector<std::string> result;
+    std::size_t begin = 0;
+    for (auto comma = s.find(','); ; comma = s.find(',', begin)) {
+        if (comma == begin || begin == s.size()) {
+            throw std::invalid_argument("empty item in list option: " + s);
+        }
+        result.push_back(s.substr(begin, comma - begin));
+        if (comma == std::string::npos) {
+            return result;
+        }
+        begin = comma + 1;
+    }
+}
+
+static TextRange get_range(const std::string& s, bool by_ordinal) {
+    TextRange range;
+    range.by_ordinal = by_ordinal;
+    auto colon = s.find(':');
+    range.begin = get_number(s.substr(0, colon));
+    if (colon != std::string::npos && colon + 1 != s.size()) {
+        range.end = get_number(s.substr(colon + 1));
+    }
+    if (range.begin > range.end) {
+        throw std::invalid_argument("empty range in options: " + s);
+    }
+    return range;
+}
+
+// value upper-cased if it is one of the names the symbol table prints in that column
+static std::string get_column_value(const std::string& value, const std::vector<std::string>& names,
+                                    const std::string& column) {
+    std::string result = value;
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return std::toupper(c); });
+    if (std::find(names.begin(), names.end(), result) == names.end()) {
+        throw std::invalid_argument("unknown symbol " + column + " " + value);
+    }
+    return result;
+}
+
+Options parse_options(const std::vector<std::string>& args) {
+    Options options;
+    for (const auto& arg : args) {
+        auto eq = arg.find('=');
+        std::string key = arg.substr(0, eq),
+                    value = (eq == std::string::npos ? "" : arg.substr(eq + 1));
+        if (key == "--insn-range") {
+            options.range = get_range(value, true);
+        } else if (key == "--addr-range") {
+            options.range = get_range(value, false);
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg == "--worker" || arg == "--worker=lines") {
+            options.worker = WorkerProtocol::LINES;
+        } else if (arg == "--worker=length") {
+            options.worker = WorkerProtocol::LENGTH;
+        } else if (key == "--jobs") {
+            options.jobs = get_number(value);
+            if (options.jobs == 0) {
+                options.jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (arg == "--compress=gzip") {
+            options.compression = Compression::GZIP;
+        } else if (arg == "--compress=zstd") {
+            options.compression = Compression::ZSTD;
+        } else if (key == "--search") {
+            options.search = value;
+        } else if (key == "--simulate") {
+            options.simulate = true;
+            options.simulate_entry = value;
+        } else if (key == "--max-steps") {
+            options.max_steps = get_number(value);
+        } else if (key == "--trace") {
+            options.trace = value;
+        } else if (arg == "--trace-format=text") {
+            options.trace_format = TraceFormat::TEXT;
+        } else if (arg == "--trace-format=bin") {
+            options.trace_format = TraceFormat::BINARY;
+        } else if (key == "--samples") {
+            options.samples = value;
+        } else if (key == "--coverage") {
+            options.coverage = split_list(value);
+        } else if (arg == "--size-report") {
+            options.size_report = SizeReport::TABLE;
+        } else if (arg == "--size-report=json") {
+            options.size_report = SizeReport::JSON;
+        } else if (arg == "--rvc-report") {
+            options.rvc_report = true;
+        } else if (arg == "--stack-report") {
+            options.stack_report = true;
+        } else if (arg == "--call-graph=dot") {
+            options.call_graph = CallGraphFormat::DOT;
+        } else if (arg == "--call-graph=json") {
+            options.call_graph = CallGraphFormat::JSON;
+        } else if (arg == "--unreferenced") {
+            options.unreferenced = true;
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (key == "--sweep") {
+            options.sweep = true;
+            if (!value.empty()) {
+                options.sweep_range = get_range(value, false);
+            }
+        } else if (arg == "--sweep-format") {
+            options.sweep_format = true;
+        } else if (arg == "--collapse-repeats") {
+            options.collapse_repeats = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--text-only") {
+            options.print_text = true;
+            options.print_symtab = false;
+        } else if (arg == "--symtab-only") {
+            options.print_text = false;
+            options.print_symtab = true;
+        } else if (key == "--sections") {
+            options.print_text = options.print_symtab = false;
+            for (const auto& section : split_list(value)) {
+                if (section == "text") {
+                    options.print_text = true;
+                } else if (section == "symtab") {
+                    options.print_symtab = true;
+                } else {
+                    throw std::invalid_argument("unknown section " + section + ", expected text or symtab");
+                }
+            }
+        } else if (key == "--functions" || key == "--functions-regex") {
+            // an empty pattern would turn the run back into the full listing
+            if (value.empty()) {
+                throw std::invalid_argument(key + " needs a pattern");
+            }
+            options.functions = value;
+            options.functions_regex = (key == "--functions-regex");
+        } else if (arg == "--sym-sort=addr") {
+            options.sym_sort = SymbolSort::ADDRESS;
+        } else if (arg == "--sym-sort=size") {
+            options.sym_sort = SymbolSort::SIZE;
+        } else if (arg == "--sym-sort=name") {
+            options.sym_sort = SymbolSort::NAME;
+        } else if (key == "--sym-type") {
+            options.sym_type = get_column_value(value, {"NOTYPE", "OBJECT", "FUNC", "SECTION", "FILE", "COMMON",
+                                                        "TLS", "LOOS", "HIOS", "LOPROC", "HIPROC"}, "type");
+        } else if (key == "--sym-bind") {
+            options.sym_bind = get_column_value(value, {"LOCAL", "GLOBAL", "WEAK", "LOOS", "HIOS", "LOPROC",
+                                                        "HIPROC"}, "bind");
+        } else if (key == "--sym-section") {
+            options.sym_section = value;
+        } else if (key == "--line-index") {
+            options.line_index = value;
+        } else if (key == "--line-index-step") {
+            options.line_index_step = get_number(value);
+            if (options.line_index_step == 0) {
+                throw std::invalid_argument("line index step must be positive");
+            }
+        } else {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+    if (!options.line_index.empty() && (!is_listing(options) || !options.print_text)) {
+        throw std::invalid_argument("--line-index needs the .text listing");
+    }
+    return options;
+}
+
+Options parse_options(int argc, char * argv[], int first) {
+    return parse_options(std::vector<std::string>(argv + std::min(first, argc), argv + argc));
+}
+
+bool is_listing(const Options& options) {
+    return options.search.empty() && options.trace.empty() && options.samples.empty() && options.coverage.empty() &&
+           options.size_report == SizeReport::NONE && !options.rvc_report && !options.stack_report &&
+           options.call_graph == CallGraphFormat::NONE && !options.unreferenced && !options.verify &&
+           options.functions.empty() && !options.simulate && !options.sweep;
+}
+
+}
@@ -0,0 +1,95 @@
+#include "profile.h"
+#include "code.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Parser {
+
+struct FunctionSamples {
+    std::size_t function;
+    const CodeSection* section;
+    std::uint32_t end;
+    std::uint64_t samples;
+};
+
+void annotate_samples(std::istream& in, std::ostream& out, const std::string& samples_file_name, TraceFormat format) {
+    auto section_headers = read_section_headers(in);
+    auto tags = calc_tags(in, section_headers);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers);
+
+    // samples per command, indexed by section and command ordinal
+    std::vector<std::vector<std::uint64_t>> counts(code.size());
+    for (std::size_t i = 0; i < code.size(); i++) {
+        counts[i].assign(code[i].index.size(), 0);
+    }
+    std::uint64_t total = 0, outside = 0;
+    TraceReader samples(samples_file_name, format);
+    std::uint32_t pc;
+    while (samples.next(pc)) {
+        total++;
+        auto section = find_code(code, pc);
+        if (section == nullptr || pc - section->address >= section->data.size() / 2 * 2) {
+            outside++;
+            continue;
+        }
+        if (find_function(functions, pc) == nullptr) {
+            outside++;
+        }
+        counts[section - code.data()][section->index.rank(pc - section->address)]++;
+    }
+
+    std::vector<FunctionSamples> hot;
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        // aliases of one function would count its samples again
+        if (i > 0 && functions[i - 1].address == functions[i].address && functions[i - 1].section == functions[i].section) {
+            continue;
+        }
+        auto section = find_function_code(code, functions[i]);
+        if (section == nullptr) {
+            continue;
+        }
+        auto end = get_function_end(functions, i, *section);
+        const auto& section_counts = counts[section - code.data()];
+        std::uint64_t samples_count = 0;
+        for (auto ordinal = section->index.rank(functions[i].address - section->address);
+             ordinal < section->index.size() && section->address + section->index.select(ordinal) < end; ordinal++) {
+            samples_count += section_counts[ordinal];
+        }
+        if (samples_count > 0) {
+            hot.push_back({i, section, end, samples_count});
+        }
+    }
+    std::stable_sort(hot.begin(), hot.end(), [](const FunctionSamples& a, const FunctionSamples& b) {
+        return a.samples > b.samples;
+    });
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%llu samples, %llu outside of functions\n",
+             static_cast<unsigned long long>(total), static_cast<unsigned long long>(outside));
+    out << buf;
+    for (const auto& entry : hot) {
+        const auto& function = functions[entry.function];
+        snprintf(buf, sizeof(buf), "\n%6.2f%% %llu ", 100.0 * entry.samples / total,
+                 static_cast<unsigned long long>(entry.samples));
+        out << buf << function.name << ":\n";
+
+        const auto& section_counts = counts[entry.section - code.data()];
+        for (auto ordinal = entry.section->index.rank(function.address - entry.section->address);
+             ordinal < entry.section->index.size(); ordinal++) {
+            std::uint32_t adr = entry.section->address + entry.section->index.select(ordinal);
+            if (adr >= entry.end) {
+                break;
+            }
+            if (section_counts[ordinal] > 0) {
+                snprintf(buf, sizeof(buf), "%7.2f%%  %08x: ", 100.0 * section_counts[ordinal] / entry.samples, adr);
+            } else {
+                snprintf(buf, sizeof(buf), "%8s  %08x: ", "", adr);
+            }
+            out << buf << describe_insn(decode(get_word(entry.section->data, adr - entry.section->address)), adr, tags);
+        }
+    }
+}
+
+}
@@ -0,0 +1,195 @@
+#include "rvc_report.h"
+#include "code.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+namespace Parser {
+
+static const std::size_t OPS_COUNT = static_cast<std::size_t>(Op::COUNT);
+
+// x8-x15, the registers of the three-bit fields
+static bool is_popular(std::uint32_t reg) {
+    return reg >= 8 && reg < 16;
+}
+
+static bool fits(std::int32_t value, std::int32_t min, std::int32_t max, std::int32_t align) {
+    return value >= min && value <= max && value % align == 0;
+}
+
+Op get_compressed_op(const DecodedInsn& insn) {
+    auto rd = insn.rd, rs1 = insn.rs1, rs2 = insn.rs2;
+    auto imm = insn.imm;
+    switch (insn.op) {
+        case Op::ADDI:
+            if (rd == 0 && rs1 == 0 && imm == 0) {
+                return Op::C_NOP;
+            }
+            if (rd == 0) {
+                return Op::UNKNOWN;
+            }
+            if (rd == 2 && rs1 == 2 && imm != 0 && fits(imm, -512, 496, 16)) {
+                return Op::C_ADDI16SP;
+            }
+            if (rs1 == 2 && is_popular(rd) && imm != 0 && fits(imm, 4, 1020, 4)) {
+                return Op::C_ADDI4SPN;
+            }
+            if (rd == rs1 && imm != 0 && fits(imm, -32, 31, 1)) {
+                return Op::C_ADDI;
+            }
+            if (rs1 == 0 && fits(imm, -32, 31, 1)) {
+                return Op::C_LI;
+            }
+            return imm == 0 && rs1 != 0 ? Op::C_MV : Op::UNKNOWN;
+        case Op::LUI:
+            return rd != 0 && rd != 2 && imm != 0 && fits(imm >> 12, -32, 31, 1) ? Op::C_LUI : Op::UNKNOWN;
+        case Op::SLLI:
+            return rd == rs1 && rd != 0 && imm != 0 ? Op::C_SLLI : Op::UNKNOWN;
+        case Op::SRLI:
+        case Op::SRAI:
+            if (rd != rs1 || !is_popular(rd) || imm == 0) {
+                return Op::UNKNOWN;
+            }
+            return insn.op == Op::SRLI ? Op::C_SRLI : Op::C_SRAI;
+        case Op::ANDI:
+            return rd == rs1 && is_popular(rd) && fits(imm, -32, 31, 1) ? Op::C_ANDI : Op::UNKNOWN;
+        case Op::ADD:
+            if (rd == 0) {
+                return Op::UNKNOWN;
+            }
+            if ((rd == rs1 && rs2 != 0) || (rd == rs2 && rs1 != 0)) {
+                return Op::C_ADD;
+            }
+            return (rs1 == 0 && rs2 != 0) || (rs2 == 0 && rs1 != 0) ? Op::C_MV : Op::UNKNOWN;
+        case Op::SUB:
+            return rd == rs1 && is_popular(rd) && is_popular(rs2) ? Op::C_SUB : Op::UNKNOWN;
+        case Op::XOR:
+        case Op::OR:
+        case Op::AND: {
+            if (!is_popular(rs1) || !is_popular(rs2) || (rd != rs1 && rd != rs2)) {
+                return Op::UNKNOWN;
+            }
+            return insn.op == Op::XOR ? Op::C_XOR : insn.op == Op::OR ? Op::C_OR : Op::C_AND;
+        }
+        case Op::LW:
+            if (rs1 == 2 && rd != 0 && fits(imm, 0, 252, 4)) {
+                return Op::C_LWSP;
+            }
+            return is_popular(rd) && is_popular(rs1) && fits(imm, 0, 124, 4) ? Op::C_LW : Op::UNKNOWN;
+        case Op::SW:
+            if (rs1 == 2 && fits(imm, 0, 252, 4)) {
+                return Op::C_SWSP;
+            }
+            return is_popular(rs1) && is_popular(rs2) && fits(imm, 0, 124, 4) ? Op::C_SW : Op::UNKNOWN;
+        case Op::JAL:
+            if (!fits(imm, -2048, 2046, 2)) {
+                return Op::UNKNOWN;
+            }
+            return rd == 0 ? Op::C_J : rd == 1 ? Op::C_JAL : Op::UNKNOWN;
+        case Op::JALR:
+            if (imm != 0 || rs1 == 0) {
+                return Op::UNKNOWN;
+            }
+            return rd == 0 ? Op::C_JR : rd == 1 ? Op::C_JALR : Op::UNKNOWN;
+        case Op::BEQ:
+        case Op::BNE:
+            if (!fits(imm, -256, 254, 2) || !((rs2 == 0 && is_popular(rs1)) || (rs1 == 0 && is_popular(rs2)))) {
+                return Op::UNKNOWN;
+            }
+            return insn.op == Op::BEQ ? Op::C_BEQZ : Op::C_BNEZ;
+        default:
+            return Op::UNKNOWN;
+    }
+}
+
+struct RvcCounts {
+    std::uint32_t wide = 0;
+    std::uint32_t compressible = 0;
+};
+
+// compressible commands per 32-bit op and per compressed op
+typedef std::vector<std::uint32_t> PairCounts;
+
+static void print_counts(std::ostream& out, const std::string& name, const RvcCounts& counts) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), ": %u of %u 32-bit commands compressible, %u bytes saved\n",
+             counts.compressible, counts.wide, 2 * counts.compressible);
+    out << name << buf;
+}
+
+void report_rvc(std::istream& in, std::ostream& out, unsigned jobs) {
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, jobs);
+
+    // pair counts are kept per chunk of consecutive functions, not per function: a table is
+    // OPS_COUNT^2 counters
+    std::vector<RvcCounts> counts(functions.size());
+    std::size_t chunks = std::min<std::size_t>(functions.size(), 4 * std::max(jobs, 1u));
+    std::vector<PairCounts> chunk_pairs(chunks);
+    auto count_function = [&](std::size_t i, PairCounts& pairs) {
+        auto section = find_function_code(code, functions[i]);
+        if (section == nullptr) {
+            return;
+        }
+        auto end = get_function_end(functions, i, *section);
+        const auto& index = section->index;
+        for (auto ordinal = index.rank(functions[i].address - section->address); ordinal < index.size(); ordinal++) {
+            auto offset = index.select(ordinal);
+            if (section->address + offset >= end) {
+                break;
+            }
+            auto insn = decode(get_word(section->data, offset));
+            if (insn.length != 4 || insn.op == Op::UNKNOWN) {
+                continue;
+            }
+            counts[i].wide++;
+            auto compressed = get_compressed_op(insn);
+            if (compressed != Op::UNKNOWN) {
+                counts[i].compressible++;
+                pairs[static_cast<std::size_t>(insn.op) * OPS_COUNT + static_cast<std::size_t>(compressed)]++;
+            }
+        }
+    };
+    parallel_for(chunks, jobs, [&](std::size_t c) {
+        chunk_pairs[c].assign(OPS_COUNT * OPS_COUNT, 0);
+        for (auto i = functions.size() * c / chunks; i < functions.size() * (c + 1) / chunks; i++) {
+            count_function(i, chunk_pairs[c]);
+        }
+    });
+
+    RvcCounts total;
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        print_counts(out, functions[i].name, counts[i]);
+        total.wide += counts[i].wide;
+        total.compressible += counts[i].compressible;
+    }
+    PairCounts total_pairs(OPS_COUNT * OPS_COUNT, 0);
+    for (const auto& pairs : chunk_pairs) {
+        for (std::size_t p = 0; p < total_pairs.size(); p++) {
+            total_pairs[p] += pairs[p];
+        }
+    }
+
+    std::vector<std::size_t> pairs;
+    for (std::size_t p = 0; p < total_pairs.size(); p++) {
+        if (total_pairs[p] > 0) {
+            pairs.push_back(p);
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [&](std::size_t a, std::size_t b) {
+        return total_pairs[a] > total_pairs[b];
+    });
+    out << "\nby mnemonic:\n";
+    char buf[128];
+    for (auto p : pairs) {
+        snprintf(buf, sizeof(buf), "%-6s -> %-10s %6u commands, %7u bytes\n", get_op_name(static_cast<Op>(p / OPS_COUNT)),
+                 get_op_name(static_cast<Op>(p % OPS_COUNT)), total_pairs[p], 2 * total_pairs[p]);
+        out << buf;
+    }
+    out << "\n";
+    print_counts(out, "total", total);
+}
+
+}
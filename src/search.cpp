@@ -0,0 +1,124 @@
+#include "search.h"
+#include "elf_parser.h"
+#include "code.h"
+#include "symbols.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Parser {
+
+std::vector<SearchPattern> compile_query(const std::string& query) {
+    std::vector<SearchPattern> patterns;
+    std::size_t start = 0;
+    while (start <= query.size()) {
+        auto end = std::min(query.find(',', start), query.size());
+        auto term = query.substr(start, end - start);
+        start = end + 1;
+        if (term.empty()) {
+            continue;
+        }
+        auto slash = term.find('/');
+        if (slash != std::string::npos) {
+            try {
+                auto mask = static_cast<std::uint32_t>(std::stoul(term.substr(0, slash), nullptr, 16));
+                auto match = static_cast<std::uint32_t>(std::stoul(term.substr(slash + 1), nullptr, 16));
+                patterns.push_back({mask, match & mask, false, Op::UNKNOWN});
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("wrong mask/match pair in query: " + term);
+            }
+            continue;
+        }
+        bool found = false;
+        for (const auto& pattern : get_patterns()) {
+            if (term == get_op_name(pattern.op)) {
+                patterns.push_back({pattern.mask, pattern.match, true, pattern.op});
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::invalid_argument("unknown command in query: " + term);
+        }
+    }
+    if (patterns.empty()) {
+        throw std::invalid_argument("empty search query");
+    }
+    return patterns;
+}
+
+// Bit j of the result is set when the little-endian word starting at halfword j of `p` matches.
+// `p` must have 64 halfwords and 16 more bytes readable.
+static std::uint64_t match_block(const char* p, std::uint32_t mask, std::uint32_t match) {
+    std::uint64_t result = 0;
+#ifdef __SSE2__
+    // lanes of an unaligned 16-byte load are the words at halfwords j, j + 2, j + 4, j + 6; a second load
+    // shifted by one halfword covers the odd ones, and spread interleaves both 4-bit compare masks
+    static const std::uint8_t spread[16] = {0, 1, 4, 5, 16, 17, 20, 21, 64, 65, 68, 69, 80, 81, 84, 85};
+    const __m128i vmask = _mm_set1_epi32(static_cast<int>(mask)),
+                  vmatch = _mm_set1_epi32(static_cast<int>(match));
+    for (int j = 0; j < 64; j += 8) {
+        __m128i even = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2 * j)),
+                odd = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2 * j + 2));
+        int even_bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(even, vmask), vmatch))),
+            odd_bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(odd, vmask), vmatch)));
+        result |= static_cast<std::uint64_t>(spread[even_bits] | (spread[odd_bits] << 1)) << j;
+    }
+#else
+    for (int j = 0; j < 64; j++) {
+        std::uint32_t word;
+        std::memcpy(&word, p + 2 * j, sizeof(word));
+        if ((word & mask) == match) {
+            result |= std::uint64_t(1) << j;
+        }
+    }
+#endif
+    return result;
+}
+
+void search(std::istream& in, std::ostream& out, const std::string& query) {
+    auto patterns = compile_query(query);
+    auto section_headers = read_section_headers(in);
+    auto tags = calc_tags(in, section_headers);
+    auto functions = collect_functions(in, section_headers);
+
+    char buf[64];
+    for (const auto& section : load_code(in, section_headers)) {
+        const auto& code = section.data;
+        const auto& starts = section.index.get_bits();
+
+        std::vector<char> padded(code);
+        padded.resize(starts.size() * 128 + 16, 0);
+
+        for (std::size_t w = 0; w < starts.size(); w++) {
+            std::uint64_t candidates = 0;
+            for (const auto& pattern : patterns) {
+                candidates |= match_block(padded.data() + 128 * w, pattern.mask, pattern.match);
+            }
+            candidates &= starts[w];
+            while (candidates != 0) {
+                std::uint32_t offset = 2 * (64 * w + __builtin_ctzll(candidates));
+                candidates &= candidates - 1;
+
+                auto word = get_word(code, offset);
+                auto insn = decode(word);
+                bool found = false;
+                for (const auto& pattern : patterns) {
+                    found |= (word & pattern.mask) == pattern.match && (!pattern.check_op || pattern.op == insn.op);
+                }
+                if (!found) {
+                    continue;
+                }
+
+                std::uint32_t adr = section.address + offset;
+                snprintf(buf, sizeof(buf), "%08x ", adr);
+                out << buf << get_location(functions, adr) << ": " << describe_insn(insn, adr, tags);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,394 @@
+#include "simulator.h"
+#include "elf_parser.h"
+#include "symbols.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace Parser {
+
+Memory::Page* Memory::get_page(std::uint32_t adr, bool allocate) {
+    auto id = adr >> PAGE_BITS;
+    if (last_page != nullptr && last_page_id == id) {
+        return last_page;
+    }
+    auto it = pages.find(id);
+    if (it == pages.end()) {
+        if (!allocate) {
+            return nullptr;
+        }
+        it = pages.emplace(id, std::unique_ptr<Page>(new Page())).first;
+    }
+    last_page_id = id;
+    last_page = it->second.get();
+    return last_page;
+}
+
+std::uint8_t Memory::load8(std::uint32_t adr) {
+    auto page = get_page(adr, false);
+    return page == nullptr ? 0 : (*page)[adr & (PAGE_SIZE - 1)];
+}
+
+std::uint16_t Memory::load16(std::uint32_t adr) {
+    return load8(adr) | (load8(adr + 1) << 8);
+}
+
+std::uint32_t Memory::load32(std::uint32_t adr) {
+    auto offset = adr & (PAGE_SIZE - 1);
+    if (offset <= PAGE_SIZE - 4) {
+        auto page = get_page(adr, false);
+        if (page == nullptr) {
+            return 0;
+        }
+        return (*page)[offset] | ((*page)[offset + 1] << 8) | ((*page)[offset + 2] << 16) |
+                (static_cast<std::uint32_t>((*page)[offset + 3]) << 24);
+    }
+    return load16(adr) | (static_cast<std::uint32_t>(load16(adr + 2)) << 16);
+}
+
+void Memory::store8(std::uint32_t adr, std::uint8_t value) {
+    (*get_page(adr, true))[adr & (PAGE_SIZE - 1)] = value;
+}
+
+void Memory::store16(std::uint32_t adr, std::uint16_t value) {
+    store8(adr, value & 0xff);
+    store8(adr + 1, value >> 8);
+}
+
+void Memory::store32(std::uint32_t adr, std::uint32_t value) {
+    store16(adr, value & 0xffff);
+    store16(adr + 2, value >> 16);
+}
+
+void Memory::store(std::uint32_t adr, const char* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        store8(adr + i, static_cast<std::uint8_t>(data[i]));
+    }
+}
+
+Simulator::Simulator(Memory memory) : memory(std::move(memory)) {}
+
+const Block& Simulator::get_block(std::uint32_t adr) {
+    auto it = blocks.find(adr);
+    if (it != blocks.end()) {
+        return it->second;
+    }
+    Block block;
+    auto end = adr;
+    while (block.insns.size() < MAX_BLOCK_LENGTH) {
+        DecodedInsn insn;
+        if (memory.is_mapped(end)) {
+            auto word = memory.load32(end);
+            // the all-zero halfword is reserved as illegal, it is what running into zeroed memory looks like
+            if ((word & 0xffff) != 0) {
+                insn = decode(word);
+            }
+            if (insn.length == 4 && !memory.is_mapped(end + 2)) {
+                insn = DecodedInsn();
+                insn.length = 0;
+            }
+        } else {
+            insn.length = 0;
+        }
+        block.insns.push_back(insn);
+        end += block.insns.back().length;
+        if (block.insns.back().op == Op::UNKNOWN || is_control_transfer(block.insns.back().op)) {
+            break;
+        }
+    }
+    decoded += block.insns.size();
+    code_begin = std::min(code_begin, adr);
+    code_end = std::max(code_end, end);
+    return blocks.emplace(adr, std::move(block)).first->second;
+}
+
+void Simulator::store_invalidate(std::uint32_t adr) {
+    if (adr + 4 > code_begin && adr < code_end) {
+        stop_reason = "code modified";
+    }
+}
+
+void Simulator::run(std::uint32_t entry, std::uint64_t max_steps) {
+    pc = entry;
+    x[1] = RETURN_ADDRESS;
+    x[2] = STACK_TOP;
+    stop_reason.clear();
+    while (pc != RETURN_ADDRESS && steps < max_steps) {
+        if (pc & 1) {
+            stop_reason = "misaligned pc";
+            return;
+        }
+        if (!run_block(get_block(pc))) {
+            return;
+        }
+        if (stop_reason == "code modified") {
+            blocks.clear();
+            code_begin = 0xffffffff;
+            code_end = 0;
+            stop_reason.clear();
+        }
+    }
+    stop_reason = (pc == RETURN_ADDRESS ? "returned from entry" : "step limit reached");
+}
+
+#if defined(__GNUC__)
+#define HANDLER(name) L_##name:
+#define DISPATCH() goto *labels[static_cast<std::size_t>(insn->op)]
+#else
+#define HANDLER(name) case Op::name:
+#define DISPATCH() continue
+#endif
+
+// advance to the next command of the block, or leave the block after its last one
+#define NEXT() { pc += insn->length; steps++; if (++insn == end || !stop_reason.empty()) return true; DISPATCH(); }
+#define JUMP(target) { pc = (target); steps++; return true; }
+#define SET(reg, value) { x[reg] = (value); x[0] = 0; }
+#define STORE(width, adr, value) { memory.store##width(adr, value); store_invalidate(adr); }
+
+bool Simulator::run_block(const Block& block) {
+    const DecodedInsn* insn = block.insns.data();
+    const DecodedInsn* end = insn + block.insns.size();
+    std::uint32_t t;
+
+#if defined(__GNUC__)
+    // label addresses are only known inside this function, so the table is filled by a statement
+    // expression; as the initializer of a local static it runs once even when simulations run in parallel
+    static void* const* const labels = ({
+        static void* table[static_cast<std::size_t>(Op::COUNT)];
+        for (auto& label : table) {
+            label = &&L_UNKNOWN;
+        }
+#define LABEL(name) table[static_cast<std::size_t>(Op::name)] = &&L_##name;
+        LABEL(C_ADDI4SPN) LABEL(C_LW) LABEL(C_SW) LABEL(C_NOP) LABEL(C_ADDI) LABEL(C_JAL) LABEL(C_LI)
+        LABEL(C_ADDI16SP) LABEL(C_LUI) LABEL(C_SRLI) LABEL(C_SRAI) LABEL(C_ANDI) LABEL(C_SUB) LABEL(C_XOR)
+        LABEL(C_OR) LABEL(C_AND) LABEL(C_J) LABEL(C_BEQZ) LABEL(C_BNEZ) LABEL(C_SLLI) LABEL(C_LWSP)
+        LABEL(C_ADD) LABEL(C_MV) LABEL(C_EBREAK) LABEL(C_JR) LABEL(C_JALR) LABEL(C_SWSP)
+        LABEL(LUI) LABEL(AUIPC) LABEL(ADDI) LABEL(SLTI) LABEL(SLTIU) LABEL(XORI) LABEL(ORI) LABEL(ANDI)
+        LABEL(SLLI) LABEL(SRLI) LABEL(SRAI) LABEL(ADD) LABEL(SUB) LABEL(SLL) LABEL(SLT) LABEL(SLTU)
+        LABEL(XOR) LABEL(SRL) LABEL(SRA) LABEL(OR) LABEL(AND) LABEL(MUL) LABEL(MULH) LABEL(MULHSU)
+        LABEL(MULHU) LABEL(DIV) LABEL(DIVU) LABEL(REM) LABEL(REMU) LABEL(LB) LABEL(LH) LABEL(LW)
+        LABEL(LBU) LABEL(LHU) LABEL(SB) LABEL(SH) LABEL(SW) LABEL(JAL) LABEL(JALR) LABEL(BEQ) LABEL(BNE)
+        LABEL(BLT) LABEL(BGE) LABEL(BLTU) LABEL(BGEU)
+#undef LABEL
+        table;
+    });
+    DISPATCH();
+#endif
+
+    for (;;) {
+#if !defined(__GNUC__)
+        switch (insn->op) {
+        default:
+#endif
+        HANDLER(UNKNOWN) {
+            char buf[64];
+            if (insn->length == 0) {
+                snprintf(buf, sizeof(buf), "illegal instruction: fetch from unmapped 0x%08x", pc);
+            } else if (insn->raw == 0) {
+                snprintf(buf, sizeof(buf), "illegal instruction 0x0000 at 0x%08x", pc);
+            } else {
+                snprintf(buf, sizeof(buf), "unsupported command %s (0x%x) at 0x%08x",
+                         get_op_name(insn->op), insn->raw, pc);
+            }
+            stop_reason = buf;
+            return false;
+        }
+        HANDLER(C_EBREAK) {
+            stop_reason = "ebreak";
+            return false;
+        }
+        HANDLER(C_NOP) NEXT()
+        HANDLER(C_ADDI4SPN)
+        HANDLER(C_ADDI)
+        HANDLER(C_ADDI16SP)
+        HANDLER(ADDI) SET(insn->rd, x[insn->rs1] + insn->imm) NEXT()
+        HANDLER(C_LI)
+        HANDLER(C_LUI)
+        HANDLER(LUI) SET(insn->rd, insn->imm) NEXT()
+        HANDLER(AUIPC) SET(insn->rd, pc + insn->imm) NEXT()
+        HANDLER(C_SRLI)
+        HANDLER(SRLI) SET(insn->rd, x[insn->rs1] >> (insn->imm & 0x1f)) NEXT()
+        HANDLER(C_SRAI)
+        HANDLER(SRAI) SET(insn->rd, static_cast<std::int32_t>(x[insn->rs1]) >> (insn->imm & 0x1f)) NEXT()
+        HANDLER(C_SLLI)
+        HANDLER(SLLI) SET(insn->rd, x[insn->rs1] << (insn->imm & 0x1f)) NEXT()
+        HANDLER(C_ANDI)
+        HANDLER(ANDI) SET(insn->rd, x[insn->rs1] & insn->imm) NEXT()
+        HANDLER(ORI) SET(insn->rd, x[insn->rs1] | insn->imm) NEXT()
+        HANDLER(XORI) SET(insn->rd, x[insn->rs1] ^ insn->imm) NEXT()
+        HANDLER(SLTI) SET(insn->rd, static_cast<std::int32_t>(x[insn->rs1]) < insn->imm) NEXT()
+        HANDLER(SLTIU) SET(insn->rd, x[insn->rs1] < static_cast<std::uint32_t>(insn->imm)) NEXT()
+        HANDLER(C_ADD)
+        HANDLER(ADD) SET(insn->rd, x[insn->rs1] + x[insn->rs2]) NEXT()
+        HANDLER(C_MV) SET(insn->rd, x[insn->rs2]) NEXT()
+        HANDLER(C_SUB)
+        HANDLER(SUB) SET(insn->rd, x[insn->rs1] - x[insn->rs2]) NEXT()
+        HANDLER(C_XOR)
+        HANDLER(XOR) SET(insn->rd, x[insn->rs1] ^ x[insn->rs2]) NEXT()
+        HANDLER(C_OR)
+        HANDLER(OR) SET(insn->rd, x[insn->rs1] | x[insn->rs2]) NEXT()
+        HANDLER(C_AND)
+        HANDLER(AND) SET(insn->rd, x[insn->rs1] & x[insn->rs2]) NEXT()
+        HANDLER(SLL) SET(insn->rd, x[insn->rs1] << (x[insn->rs2] & 0x1f)) NEXT()
+        HANDLER(SRL) SET(insn->rd, x[insn->rs1] >> (x[insn->rs2] & 0x1f)) NEXT()
+        HANDLER(SRA) SET(insn->rd, static_cast<std::int32_t>(x[insn->rs1]) >> (x[insn->rs2] & 0x1f)) NEXT()
+        HANDLER(SLT) SET(insn->rd, static_cast<std::int32_t>(x[insn->rs1]) < static_cast<std::int32_t>(x[insn->rs2])) NEXT()
+        HANDLER(SLTU) SET(insn->rd, x[insn->rs1] < x[insn->rs2]) NEXT()
+        HANDLER(MUL) SET(insn->rd, x[insn->rs1] * x[insn->rs2]) NEXT()
+        HANDLER(MULH) SET(insn->rd, static_cast<std::uint32_t>(
+                (static_cast<std::int64_t>(static_cast<std::int32_t>(x[insn->rs1])) *
+                 static_cast<std::int32_t>(x[insn->rs2])) >> 32)) NEXT()
+        HANDLER(MULHSU) SET(insn->rd, static_cast<std::uint32_t>(
+                (static_cast<std::int64_t>(static_cast<std::int32_t>(x[insn->rs1])) *
+                 static_cast<std::int64_t>(x[insn->rs2])) >> 32)) NEXT()
+        HANDLER(MULHU) SET(insn->rd, static_cast<std::uint32_t>(
+                (static_cast<std::uint64_t>(x[insn->rs1]) * x[insn->rs2]) >> 32)) NEXT()
+        HANDLER(DIV) {
+            auto a = static_cast<std::int32_t>(x[insn->rs1]), b = static_cast<std::int32_t>(x[insn->rs2]);
+            if (b == 0) {
+                t = 0xffffffff;
+            } else if (a == INT32_MIN && b == -1) {
+                t = x[insn->rs1];
+            } else {
+                t = static_cast<std::uint32_t>(a / b);
+            }
+            SET(insn->rd, t) NEXT()
+        }
+        HANDLER(DIVU) SET(insn->rd, x[insn->rs2] == 0 ? 0xffffffff : x[insn->rs1] / x[insn->rs2]) NEXT()
+        HANDLER(REM) {
+            auto a = static_cast<std::int32_t>(x[insn->rs1]), b = static_cast<std::int32_t>(x[insn->rs2]);
+            if (b == 0) {
+                t = x[insn->rs1];
+            } else if (a == INT32_MIN && b == -1) {
+                t = 0;
+            } else {
+                t = static_cast<std::uint32_t>(a % b);
+            }
+            SET(insn->rd, t) NEXT()
+        }
+        HANDLER(REMU) SET(insn->rd, x[insn->rs2] == 0 ? x[insn->rs1] : x[insn->rs1] % x[insn->rs2]) NEXT()
+        HANDLER(LB) SET(insn->rd, static_cast<std::int8_t>(memory.load8(x[insn->rs1] + insn->imm))) NEXT()
+        HANDLER(LH) SET(insn->rd, static_cast<std::int16_t>(memory.load16(x[insn->rs1] + insn->imm))) NEXT()
+        HANDLER(LBU) SET(insn->rd, memory.load8(x[insn->rs1] + insn->imm)) NEXT()
+        HANDLER(LHU) SET(insn->rd, memory.load16(x[insn->rs1] + insn->imm)) NEXT()
+        HANDLER(C_LW)
+        HANDLER(C_LWSP)
+        HANDLER(LW) SET(insn->rd, memory.load32(x[insn->rs1] + insn->imm)) NEXT()
+        HANDLER(SB) STORE(8, x[insn->rs1] + insn->imm, static_cast<std::uint8_t>(x[insn->rs2])) NEXT()
+        HANDLER(SH) STORE(16, x[insn->rs1] + insn->imm, static_cast<std::uint16_t>(x[insn->rs2])) NEXT()
+        HANDLER(C_SW)
+        HANDLER(C_SWSP)
+        HANDLER(SW) STORE(32, x[insn->rs1] + insn->imm, x[insn->rs2]) NEXT()
+        HANDLER(C_J) JUMP(pc + insn->imm)
+        HANDLER(C_JAL) {
+            x[1] = pc + 2;
+            JUMP(pc + insn->imm)
+        }
+        HANDLER(JAL) {
+            t = pc;
+            SET(insn->rd, pc + 4)
+            JUMP(t + insn->imm)
+        }
+        HANDLER(C_JR) JUMP(x[insn->rs1] & ~1u)
+        HANDLER(C_JALR) {
+            t = x[insn->rs1] & ~1u;
+            x[1] = pc + 2;
+            JUMP(t)
+        }
+        HANDLER(JALR) {
+            t = (x[insn->rs1] + insn->imm) & ~1u;
+            SET(insn->rd, pc + 4)
+            JUMP(t)
+        }
+        HANDLER(C_BEQZ) JUMP(x[insn->rs1] == 0 ? pc + insn->imm : pc + 2)
+        HANDLER(C_BNEZ) JUMP(x[insn->rs1] != 0 ? pc + insn->imm : pc + 2)
+        HANDLER(BEQ) JUMP(x[insn->rs1] == x[insn->rs2] ? pc + insn->imm : pc + 4)
+        HANDLER(BNE) JUMP(x[insn->rs1] != x[insn->rs2] ? pc + insn->imm : pc + 4)
+        HANDLER(BLT) JUMP(static_cast<std::int32_t>(x[insn->rs1]) < static_cast<std::int32_t>(x[insn->rs2])
+                          ? pc + insn->imm : pc + 4)
+        HANDLER(BGE) JUMP(static_cast<std::int32_t>(x[insn->rs1]) >= static_cast<std::int32_t>(x[insn->rs2])
+                          ? pc + insn->imm : pc + 4)
+        HANDLER(BLTU) JUMP(x[insn->rs1] < x[insn->rs2] ? pc + insn->imm : pc + 4)
+        HANDLER(BGEU) JUMP(x[insn->rs1] >= x[insn->rs2] ? pc + insn->imm : pc + 4)
+#if !defined(__GNUC__)
+        }
+#endif
+    }
+}
+
+#undef HANDLER
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef SET
+#undef STORE
+
+static std::uint32_t get_entry(
+        std::istream& in,
+        const std::vector<Elf32_section_header>& section_headers,
+        const std::string& entry
+) {
+    if (entry.empty()) {
+        return read_file_header(in).e_entry;
+    }
+    for (const auto& function : collect_functions(in, section_headers)) {
+        if (function.name == entry) {
+            return function.address;
+        }
+    }
+    try {
+        std::size_t pos;
+        auto adr = std::stoul(entry, &pos, 0);
+        if (pos == entry.size()) {
+            return static_cast<std::uint32_t>(adr);
+        }
+    } catch (const std::logic_error&) {
+    }
+    throw std::invalid_argument("unknown simulation entry " + entry);
+}
+
+void simulate(std::istream& in, std::ostream& out, const std::string& entry, std::uint64_t max_steps) {
+    auto section_headers = read_section_headers(in);
+    auto entry_address = get_entry(in, section_headers, entry);
+
+    Memory memory;
+    bool loaded = false;
+    for (const auto& p_header : read_program_headers(in)) {
+        if (p_header.p_type == PT_LOAD && p_header.p_filesz > 0) {
+            std::vector<char> data(p_header.p_filesz);
+            in.seekg(p_header.p_offset);
+            in.read(data.data(), static_cast<std::streamsize>(data.size()));
+            memory.store(p_header.p_vaddr, data.data(), data.size());
+            loaded = true;
+        }
+    }
+    if (!loaded) {
+        const auto& text_header = section_headers[find_section(section_headers, TEXT_TYPE)];
+        auto text = read_section(in, text_header);
+        memory.store(text_header.sh_addr, text.data(), text.size());
+    }
+
+    Simulator simulator(std::move(memory));
+    auto start = std::chrono::steady_clock::now();
+    simulator.run(entry_address, max_steps);
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Simulation from 0x%08x: %s, pc 0x%08x\n",
+             entry_address, simulator.get_stop_reason().c_str(), simulator.get_pc());
+    out << buf;
+    snprintf(buf, sizeof(buf), "%llu commands, %zu blocks (%llu commands decoded), %.3f s, %.2f MIPS\n",
+             static_cast<unsigned long long>(simulator.get_steps()),
+             simulator.get_blocks_count(),
+             static_cast<unsigned long long>(simulator.get_decoded_count()),
+             seconds.count(),
+             seconds.count() > 0 ? simulator.get_steps() / seconds.count() / 1e6 : 0.0);
+    out << buf;
+    for (std::uint32_t i = 0; i < 32; i++) {
+        snprintf(buf, sizeof(buf), "%4s 0x%08x%s", get_reg(i).c_str(), simulator.get_reg_value(i), i % 4 == 3 ? "\n" : "  ");
+        out << buf;
+    }
+}
+
+}
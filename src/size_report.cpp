@@ -0,0 +1,143 @@
+#include "size_report.h"
+#include "code.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+namespace Parser {
+
+static const std::size_t TOP_MNEMONICS = 3;
+
+struct SizeEntry {
+    std::string name;
+    const CodeSection* section;
+    std::uint32_t begin;
+    std::uint32_t end;
+    std::uint32_t commands = 0;
+    std::uint32_t compressed = 0;
+    std::vector<std::pair<std::uint32_t, Op>> top;
+};
+
+static void count_commands(SizeEntry& entry) {
+    const auto& index = entry.section->index;
+    std::uint32_t counts[static_cast<std::size_t>(Op::COUNT)] = {};
+    std::uint32_t offset = entry.begin - entry.section->address;
+    for (auto ordinal = index.is_start(offset) ? index.rank(offset) : index.rank(offset) + 1;
+         ordinal < index.size(); ordinal++) {
+        offset = index.select(ordinal);
+        if (entry.section->address + offset >= entry.end) {
+            break;
+        }
+        auto insn = decode(get_word(entry.section->data, offset));
+        entry.commands++;
+        entry.compressed += (insn.length == 2);
+        counts[static_cast<std::size_t>(insn.op)]++;
+    }
+    for (std::size_t op = 0; op < static_cast<std::size_t>(Op::COUNT); op++) {
+        if (counts[op] > 0) {
+            entry.top.emplace_back(counts[op], static_cast<Op>(op));
+        }
+    }
+    std::stable_sort(entry.top.begin(), entry.top.end(), [](const std::pair<std::uint32_t, Op>& a,
+                                                            const std::pair<std::uint32_t, Op>& b) {
+        return a.first > b.first;
+    });
+    if (entry.top.size() > TOP_MNEMONICS) {
+        entry.top.resize(TOP_MNEMONICS);
+    }
+}
+
+static double get_ratio(const SizeEntry& entry) {
+    return entry.commands == 0 ? 0.0 : 100.0 * entry.compressed / entry.commands;
+}
+
+static void print_table(std::ostream& out, const std::vector<SizeEntry>& entries) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%8s %8s %8s %7s  %s\n", "address", "size", "commands", "rvc", "name: top mnemonics");
+    out << buf;
+    std::uint64_t total = 0;
+    for (const auto& entry : entries) {
+        snprintf(buf, sizeof(buf), "%08x %8u %8u %6.2f%%  ", entry.begin, entry.end - entry.begin, entry.commands,
+                 get_ratio(entry));
+        out << buf << entry.name << ':';
+        for (std::size_t i = 0; i < entry.top.size(); i++) {
+            out << ' ' << get_op_name(entry.top[i].second) << ':' << entry.top[i].first;
+        }
+        out << "\n";
+        total += entry.end - entry.begin;
+    }
+    snprintf(buf, sizeof(buf), "%8s %8llu\n", "total", static_cast<unsigned long long>(total));
+    out << buf;
+}
+
+static void print_json(std::ostream& out, const std::vector<SizeEntry>& entries) {
+    char buf[128];
+    out << "[";
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const auto& entry = entries[i];
+        out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"" << escape_json(entry.name) << "\", ";
+        snprintf(buf, sizeof(buf), "\"address\": %u, \"size\": %u, \"commands\": %u, \"compressed\": %u, \"top\": {",
+                 entry.begin, entry.end - entry.begin, entry.commands, entry.compressed);
+        out << buf;
+        for (std::size_t j = 0; j < entry.top.size(); j++) {
+            out << (j == 0 ? "" : ", ") << '"' << get_op_name(entry.top[j].second) << "\": " << entry.top[j].first;
+        }
+        out << "}}";
+    }
+    out << "\n]\n";
+}
+
+void report_sizes(std::istream& in, std::ostream& out, SizeReport format, unsigned jobs) {
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers, jobs);
+
+    // functions are sorted by address, so every section is cut into consecutive ranges; a function
+    // starting inside the previous one only gets the bytes after it
+    std::vector<SizeEntry> entries;
+    for (const auto& section : code) {
+        std::uint32_t cursor = section.address;
+        std::uint32_t section_end = section.address + section.data.size();
+        auto add = [&](const std::string& name, std::uint32_t begin, std::uint32_t end) {
+            SizeEntry entry;
+            entry.name = name;
+            entry.section = &section;
+            entry.begin = begin;
+            entry.end = end;
+            entries.push_back(std::move(entry));
+        };
+        for (std::size_t i = 0; i < functions.size(); i++) {
+            if (find_function_code(code, functions[i]) != &section) {
+                continue;
+            }
+            auto end = get_function_end(functions, i, section);
+            if (end <= cursor) {
+                continue;
+            }
+            if (functions[i].address > cursor) {
+                add("unattributed", cursor, functions[i].address);
+            }
+            add(functions[i].name, std::max(cursor, functions[i].address), end);
+            cursor = end;
+        }
+        if (cursor < section_end) {
+            add("unattributed", cursor, section_end);
+        }
+    }
+
+    parallel_for(entries.size(), jobs, [&](std::size_t i) {
+        count_commands(entries[i]);
+    });
+    std::stable_sort(entries.begin(), entries.end(), [](const SizeEntry& a, const SizeEntry& b) {
+        return a.end - a.begin > b.end - b.begin;
+    });
+
+    if (format == SizeReport::JSON) {
+        print_json(out, entries);
+    } else {
+        print_table(out, entries);
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+#include "stack_report.h"
+#include "call_graph.h"
+#include <cstdio>
+#include <ostream>
+#include <utility>
+
+namespace Parser {
+
+static const std::size_t NONE = static_cast<std::size_t>(-1);
+
+struct StackUsage {
+    std::uint32_t frame = 0;
+    std::uint32_t saved = 0;  // mask of registers stored relative to sp
+    std::uint64_t depth = 0;
+    std::size_t next = NONE;  // callee on the deepest path
+    bool recursive = false;
+    bool indirect = false;
+};
+
+// the prologue runs up to the first control transfer: sp decrements make the frame, stores
+// relative to sp are spills
+static void scan_prologue(const FunctionCode& function_code, StackUsage& usage) {
+    for (auto ordinal = function_code.first; ordinal < function_code.last; ordinal++) {
+        auto insn = decode(get_word(function_code.section->data, function_code.section->index.select(ordinal)));
+        if (insn.op == Op::UNKNOWN || is_control_transfer(insn.op)) {
+            break;
+        }
+        bool sp_adjust = (insn.op == Op::ADDI || insn.op == Op::C_ADDI || insn.op == Op::C_ADDI16SP) &&
+                insn.rd == 2 && insn.rs1 == 2;
+        if (sp_adjust && insn.imm < 0) {
+            usage.frame += -insn.imm;
+        } else if ((insn.op == Op::SW || insn.op == Op::C_SWSP) && insn.rs1 == 2) {
+            usage.saved |= 1u << insn.rs2;
+        }
+    }
+}
+
+// depth-first over the call graph without recursion, so deep call chains in the input can not
+// overflow our own stack; a callee still on the path closes a cycle
+static void calc_depths(const CallGraph& graph, std::vector<StackUsage>& usage) {
+    enum State { NEW, ON_PATH, DONE };
+    std::vector<State> state(usage.size(), NEW);
+    for (std::size_t root = 0; root < usage.size(); root++) {
+        if (state[root] != NEW) {
+            continue;
+        }
+        std::vector<std::pair<std::size_t, std::size_t>> path = {{root, 0}};
+        state[root] = ON_PATH;
+        while (!path.empty()) {
+            auto& top = path.back();
+            const auto& calls = graph.calls[top.first];
+            if (top.second < calls.size()) {
+                auto callee = calls[top.second++].callee;
+                if (state[callee] == NEW) {
+                    state[callee] = ON_PATH;
+                    path.push_back({callee, 0});
+                }
+                continue;
+            }
+            auto& current = usage[top.first];
+            current.indirect = graph.indirect[top.first];
+            current.depth = current.frame;
+            for (const auto& call : calls) {
+                if (state[call.callee] == ON_PATH) {
+                    current.recursive = true;
+                    continue;
+                }
+                const auto& callee = usage[call.callee];
+                current.recursive |= callee.recursive;
+                current.indirect |= callee.indirect;
+                // a tail callee runs after our frame is popped, so it deepens the stack only past our frame
+                auto depth = (call.tail ? 0 : current.frame) + callee.depth;
+                if (depth > current.depth || (current.next == NONE && !call.tail)) {
+                    current.next = call.callee;
+                    current.depth = depth;
+                }
+            }
+            state[top.first] = DONE;
+            path.pop_back();
+        }
+    }
+}
+
+static std::string get_saved_list(std::uint32_t saved) {
+    std::string result;
+    for (std::uint32_t reg = 0; reg < 32; reg++) {
+        if ((saved >> reg) & 1) {
+            result += (result.empty() ? "" : ", ") + get_reg(reg);
+        }
+    }
+    return result;
+}
+
+void report_stack(std::istream& in, std::ostream& out) {
+    auto entry = read_file_header(in).e_entry;
+    auto section_headers = read_section_headers(in);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers);
+    auto graph = build_call_graph(functions, code);
+
+    std::vector<StackUsage> usage(functions.size());
+    std::vector<bool> called(functions.size(), false);
+    char buf[64];
+    out << "frames:\n";
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        auto function_code = get_function_code(functions, i, code);
+        if (function_code.section != nullptr) {
+            scan_prologue(function_code, usage[i]);
+        }
+        for (const auto& call : graph.calls[i]) {
+            called[call.callee] = called[call.callee] || call.callee != i;
+        }
+        snprintf(buf, sizeof(buf), ": %u bytes", usage[i].frame);
+        out << functions[i].name << buf;
+        if (usage[i].saved != 0) {
+            out << ", saves " << get_saved_list(usage[i].saved);
+        }
+        out << "\n";
+    }
+    calc_depths(graph, usage);
+
+    out << "\nworst-case stack of entry points:\n";
+    // relocatable files have no entry
+    auto entry_function = (entry == 0 ? functions.size() : find_function_index(functions, entry));
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        if (called[i] && i != entry_function) {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), ": %llu%s bytes", static_cast<unsigned long long>(usage[i].depth),
+                 usage[i].recursive || usage[i].indirect ? "+" : "");
+        out << functions[i].name << buf;
+        if (usage[i].recursive) {
+            out << " (recursion)";
+        }
+        if (usage[i].indirect) {
+            out << " (indirect calls)";
+        }
+        std::string separator = ", ";
+        for (auto f = i; f != NONE; f = usage[f].next) {
+            out << separator << functions[f].name;
+            separator = " -> ";
+        }
+        out << "\n";
+    }
+}
+
+}
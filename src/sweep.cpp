@@ -0,0 +1,131 @@
+#include "sweep.h"
+#include "elf_parser.h"
+#include "parallel.h"
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+
+namespace Parser {
+
+static const std::uint64_t CHUNK_SIZE = 1 << 22;
+// low 7 bits of 32-bit commands and quadrant plus funct3 of 16-bit ones never collide
+static const std::size_t OPCODES_COUNT = 128;
+static const std::size_t OPS_COUNT = static_cast<std::size_t>(Op::COUNT);
+
+struct SweepStats {
+    std::uint64_t valid[OPCODES_COUNT] = {};
+    std::uint64_t unknown[OPCODES_COUNT] = {};
+    std::uint64_t failed[OPCODES_COUNT] = {};
+    std::uint64_t ops[OPS_COUNT] = {};
+    // first failing word and its error per opcode
+    std::uint32_t failed_word[OPCODES_COUNT] = {};
+    std::string error[OPCODES_COUNT];
+};
+
+static std::size_t get_opcode(std::uint32_t word) {
+    if ((word & 0x3) == 0x3) {
+        return word & 0x7f;
+    }
+    return (word & 0x3) | (((word >> 13) & 0x7) << 2);
+}
+
+static std::string get_opcode_name(std::size_t opcode) {
+    // room for "c" and two 20 digit size_t values, which is what the compiler checks against
+    char buf[48];
+    if ((opcode & 0x3) == 0x3) {
+        snprintf(buf, sizeof(buf), "0x%02zx", opcode);
+    } else {
+        snprintf(buf, sizeof(buf), "c%zu.%zu", opcode & 0x3, opcode >> 2);
+    }
+    return buf;
+}
+
+static void sweep_chunk(std::uint64_t begin, std::uint64_t end, bool format, SweepStats& stats) {
+    std::map<std::uint32_t, std::string> no_tags;
+    for (auto w = begin; w < end; w++) {
+        auto word = static_cast<std::uint32_t>(w);
+        auto opcode = get_opcode(word);
+        auto insn = decode(word);
+        stats.ops[static_cast<std::size_t>(insn.op)]++;
+        if (insn.op == Op::UNKNOWN) {
+            stats.unknown[opcode]++;
+            continue;
+        }
+        if (format) {
+            try {
+                format_insn(insn, 0, no_tags);
+            } catch (const std::exception& e) {
+                if (stats.failed[opcode]++ == 0) {
+                    stats.failed_word[opcode] = word;
+                    stats.error[opcode] = e.what();
+                }
+                continue;
+            }
+        }
+        stats.valid[opcode]++;
+    }
+}
+
+void sweep(std::ostream& out, std::uint64_t begin, std::uint64_t end, bool format, unsigned jobs) {
+    std::size_t chunks = (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<SweepStats> stats(chunks);
+    auto start = std::chrono::steady_clock::now();
+    parallel_for(chunks, jobs, [&](std::size_t i) {
+        auto chunk_begin = begin + i * CHUNK_SIZE;
+        sweep_chunk(chunk_begin, std::min(end, chunk_begin + CHUNK_SIZE), format, stats[i]);
+    });
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    SweepStats total;
+    for (std::size_t i = 0; i < chunks; i++) {
+        for (std::size_t opcode = 0; opcode < OPCODES_COUNT; opcode++) {
+            total.valid[opcode] += stats[i].valid[opcode];
+            total.unknown[opcode] += stats[i].unknown[opcode];
+            if (stats[i].failed[opcode] > 0 && total.failed[opcode] == 0) {
+                total.failed_word[opcode] = stats[i].failed_word[opcode];
+                total.error[opcode] = stats[i].error[opcode];
+            }
+            total.failed[opcode] += stats[i].failed[opcode];
+        }
+        for (std::size_t op = 0; op < OPS_COUNT; op++) {
+            total.ops[op] += stats[i].ops[op];
+        }
+    }
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Swept 0x%08llx-0x%08llx: %llu words in %.3f s, %.2f M words/s\n",
+             static_cast<unsigned long long>(begin), static_cast<unsigned long long>(end - 1),
+             static_cast<unsigned long long>(end - begin), seconds.count(),
+             seconds.count() > 0 ? (end - begin) / seconds.count() / 1e6 : 0.0);
+    out << buf;
+
+    snprintf(buf, sizeof(buf), "\n%-7s %12s %12s %12s\n", "opcode", "valid", "unknown", "failed");
+    out << buf;
+    for (std::size_t opcode = 0; opcode < OPCODES_COUNT; opcode++) {
+        if (total.valid[opcode] + total.unknown[opcode] + total.failed[opcode] == 0) {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "%-7s %12llu %12llu %12llu", get_opcode_name(opcode).c_str(),
+                 static_cast<unsigned long long>(total.valid[opcode]),
+                 static_cast<unsigned long long>(total.unknown[opcode]),
+                 static_cast<unsigned long long>(total.failed[opcode]));
+        out << buf;
+        if (total.failed[opcode] > 0) {
+            snprintf(buf, sizeof(buf), "  first 0x%08x: ", total.failed_word[opcode]);
+            out << buf << total.error[opcode];
+        }
+        out << "\n";
+    }
+
+    out << "\n";
+    for (std::size_t op = 0; op < OPS_COUNT; op++) {
+        if (total.ops[op] > 0) {
+            snprintf(buf, sizeof(buf), "%-16s %12llu\n", get_op_name(static_cast<Op>(op)),
+                     static_cast<unsigned long long>(total.ops[op]));
+            out << buf;
+        }
+    }
+}
+
+}
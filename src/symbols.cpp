@@ -0,0 +1,63 @@
+#include "symbols.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Parser {
+
+std::vector<Function> collect_functions(std::istream& in, const std::vector<Elf32_section_header>& section_headers) {
+    std::vector<Function> functions;
+    for (std::uint32_t symtab_id = 0; symtab_id < section_headers.size(); symtab_id++) {
+        const auto& s_header = section_headers[symtab_id];
+        if (s_header.sh_type != SYMTAB_TYPE || s_header.sh_link >= section_headers.size()) {
+            continue;
+        }
+        auto symbols = read_section(in, s_header);
+        auto shndx = read_symtab_shndx(in, section_headers, symtab_id);
+        auto strtab = read_section(in, section_headers[s_header.sh_link]);
+        for (std::size_t i = 0; i + sizeof(Elf32_Sym) <= symbols.size(); i += sizeof(Elf32_Sym)) {
+            Elf32_Sym sym;
+            std::memcpy(&sym, symbols.data() + i, sizeof(sym));
+            if ((sym.st_info & 0xf) != STT_FUNC || sym.st_name >= strtab.size()) {
+                continue;
+            }
+            functions.push_back({
+                std::string(strtab.data() + sym.st_name, strnlen(strtab.data() + sym.st_name, strtab.size() - sym.st_name)),
+                sym.st_value,
+                sym.st_size,
+                get_symbol_section(sym, i / sizeof(Elf32_Sym), shndx),
+                static_cast<std::uint8_t>(sym.st_info >> 4)
+            });
+        }
+    }
+    std::sort(functions.begin(), functions.end(), [](const Function& a, const Function& b) {
+        return a.address != b.address ? a.address < b.address : a.section < b.section;
+    });
+    return functions;
+}
+
+const Function* find_function(const std::vector<Function>& functions, std::uint32_t address) {
+    auto it = std::upper_bound(functions.begin(), functions.end(), address, [](std::uint32_t adr, const Function& f) {
+        return adr < f.address;
+    });
+    if (it == functions.begin()) {
+        return nullptr;
+    }
+    --it;
+    if (it->size != 0) {
+        return address - it->address < it->size ? &*it : nullptr;
+    }
+    return &*it;
+}
+
+std::string get_location(const std::vector<Function>& functions, std::uint32_t address) {
+    auto function = find_function(functions, address);
+    if (function == nullptr) {
+        return "?";
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "+0x%x", address - function->address);
+    return function->name + buf;
+}
+
+}
@@ -0,0 +1,93 @@
+#include "trace.h"
+#include "code.h"
+#include "symbols.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Parser {
+
+static const std::size_t TRACE_BUFFER_SIZE = 1 << 20;
+
+TraceReader::TraceReader(const std::string& file_name, TraceFormat format)
+        : in(file_name, std::ios::binary), format(format), buffer(TRACE_BUFFER_SIZE) {
+    if (!in) {
+        throw std::invalid_argument("can't open trace file " + file_name);
+    }
+}
+
+// keeps the unread tail and appends the next chunk of the file
+bool TraceReader::fill() {
+    std::copy(buffer.begin() + position, buffer.begin() + size, buffer.begin());
+    size -= position;
+    position = 0;
+    in.read(buffer.data() + size, static_cast<std::streamsize>(buffer.size() - size));
+    size += in.gcount();
+    return in.gcount() > 0;
+}
+
+bool TraceReader::next(std::uint32_t& pc) {
+    if (format == TraceFormat::BINARY) {
+        if (size - position < 4 && !fill() && size - position < 4) {
+            return false;
+        }
+        auto p = reinterpret_cast<const unsigned char *>(buffer.data() + position);
+        pc = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        position += 4;
+        return true;
+    }
+    while (true) {
+        auto line_end = std::find(buffer.begin() + position, buffer.begin() + size, '\n') - buffer.begin();
+        if (static_cast<std::size_t>(line_end) == size && in && fill()) {
+            continue;
+        }
+        if (position == size) {
+            return false;
+        }
+        std::string line(buffer.data() + position, buffer.data() + line_end);
+        position = std::min<std::size_t>(line_end + 1, size);
+        auto comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.resize(comment);
+        }
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        try {
+            pc = static_cast<std::uint32_t>(std::stoul(line, nullptr, 16));
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument("wrong PC in trace: " + line);
+        }
+        return true;
+    }
+}
+
+void annotate_trace(std::istream& in, std::ostream& out, const std::string& trace_file_name, TraceFormat format) {
+    auto section_headers = read_section_headers(in);
+    auto tags = calc_tags(in, section_headers);
+    auto functions = collect_functions(in, section_headers);
+    auto code = load_code(in, section_headers);
+
+    std::unordered_map<std::uint32_t, std::string> lines;
+    TraceReader trace(trace_file_name, format);
+    std::uint32_t pc;
+    char buf[16];
+    while (trace.next(pc)) {
+        auto it = lines.find(pc);
+        if (it == lines.end()) {
+            snprintf(buf, sizeof(buf), "%08x ", pc);
+            std::string line = buf + get_location(functions, pc) + ": ";
+            auto section = find_code(code, pc);
+            if (section == nullptr) {
+                line += "outside of code\n";
+            } else {
+                line += describe_insn(decode(get_word(section->data, pc - section->address)), pc, tags);
+            }
+            it = lines.emplace(pc, std::move(line)).first;
+        }
+        out.write(it->second.data(), static_cast<std::streamsize>(it->second.size()));
+    }
+}
+
+}
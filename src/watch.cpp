@@ -0,0 +1,217 @@
+#include "watch.h"
+#include "archive.h"
+#include "elf_parser.h"
+#include "instruction_index.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Parser {
+
+static std::uint64_t get_hash(const char* data, std::size_t size, std::uint64_t hash = 14695981039346656037ull) {
+    for (std::size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::uint64_t get_hash(std::uint64_t value, std::uint64_t hash) {
+    return get_hash(reinterpret_cast<const char *>(&value), sizeof(value), hash);
+}
+
+// rendered listing pieces from the previous run, keyed by the hash of everything they depend on
+struct WatchCache {
+    std::unordered_map<std::uint64_t, std::string> chunks;
+    std::uint64_t symtab_hash = 0;
+    std::string symtab;
+    // texts of address-independent commands do not depend on the tags, so they outlive a run
+    FormatCache format_cache;
+};
+
+static void update_output(
+        const std::string& input_file_name,
+        const std::string& output_file_name,
+        const Options& options,
+        WatchCache& cache
+) {
+    std::ifstream in(input_file_name, std::ios::binary);
+    in.exceptions(std::ifstream::failbit | std::ifstream::eofbit);
+
+    auto section_headers = read_section_headers(in);
+    auto tags = calc_tags(in, section_headers);
+    auto text = read_section(in, section_headers[find_section(section_headers, TEXT_TYPE)]);
+    InstructionIndex index(text);
+
+    // branch targets are printed through tags, so every chunk depends on the whole tag table
+    std::uint64_t tags_hash = get_hash(tags.size(), 0);
+    for (const auto& tag : tags) {
+        tags_hash = get_hash(tag.first, get_hash(tag.second.data(), tag.second.size(), tags_hash));
+    }
+
+    std::vector<std::uint32_t> bounds = {0};
+    for (const auto& tag : tags) {
+        if (tag.first > bounds.back() && tag.first < text.size() && index.is_start(tag.first)) {
+            bounds.push_back(tag.first);
+        }
+    }
+    bounds.push_back(text.size());
+
+    std::unordered_map<std::uint64_t, std::string> chunks;
+    std::vector<std::uint64_t> keys;
+    std::size_t rendered = 0;
+    for (std::size_t i = 0; i + 1 < bounds.size(); i++) {
+        auto key = get_hash(bounds[i], get_hash(text.data() + bounds[i], bounds[i + 1] - bounds[i], tags_hash));
+        keys.push_back(key);
+        auto it = cache.chunks.find(key);
+        if (it != cache.chunks.end()) {
+            chunks[key] = std::move(it->second);
+        } else {
+            std::ostringstream chunk;
+            parse_text(text, chunk, tags, bounds[i], bounds[i + 1], options.collapse_repeats,
+                       &cache.format_cache);
+            chunks[key] = chunk.str();
+            rendered++;
+        }
+    }
+
+    std::uint64_t symtab_hash = 0;
+    for (auto type : {SYMTAB_TYPE, STRTAB_TYPE}) {
+        auto data = read_section(in, section_headers[find_section(section_headers, type)]);
+        symtab_hash = get_hash(data.data(), data.size(), get_hash(data.size(), symtab_hash));
+    }
+    if (symtab_hash != cache.symtab_hash || cache.symtab.empty()) {
+        std::ostringstream symtab;
+        parse_symtab(in, symtab, section_headers, options);
+        cache.symtab = symtab.str();
+        cache.symtab_hash = symtab_hash;
+    }
+
+    std::ofstream out(output_file_name, std::ios::trunc);
+    out.write(".text\n", 6);
+    for (auto key : keys) {
+        const auto& chunk = chunks[key];
+        out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+    out.write("\n.symtab\n", 9);
+    out.write(cache.symtab.data(), static_cast<std::streamsize>(cache.symtab.size()));
+    cache.chunks = std::move(chunks);
+
+    std::cout << "Updated " << output_file_name << ": " << rendered << " of " << keys.size()
+              << " functions disassembled" << std::endl;
+}
+
+#ifdef __linux__
+
+// inotify watch on the directory of a file, so that replacing the file is seen too. It is set up
+// before the first render, so changes made while rendering stay queued for the next wait.
+class ChangeWatcher {
+public:
+    explicit ChangeWatcher(const std::string& file_name) {
+        auto slash = file_name.find_last_of('/');
+        dir = (slash == std::string::npos ? "." : file_name.substr(0, slash + 1));
+        base = (slash == std::string::npos ? file_name : file_name.substr(slash + 1));
+        fd = inotify_init1(IN_NONBLOCK);
+        if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            throw std::invalid_argument("can't watch " + dir);
+        }
+    }
+
+    ~ChangeWatcher() {
+        close(fd);
+    }
+
+    ChangeWatcher(const ChangeWatcher&) = delete;
+    ChangeWatcher& operator=(const ChangeWatcher&) = delete;
+
+    // blocks until the file is rewritten, replaced or moved into place, then drains the events already
+    // queued, since the next render sees their changes anyway
+    void wait() {
+        bool changed = false;
+        while (!changed) {
+            pollfd request{fd, POLLIN, 0};
+            if (poll(&request, 1, -1) < 0 && errno != EINTR) {
+                throw std::invalid_argument("can't watch " + dir);
+            }
+            changed = read_events();
+        }
+        while (read_events()) {
+        }
+    }
+
+private:
+    // reads the queued events without blocking, true if one of them is about the file
+    bool read_events() {
+        alignas(inotify_event) char buf[4096];
+        bool changed = false;
+        while (true) {
+            auto length = read(fd, buf, sizeof(buf));
+            if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+                return changed;
+            }
+            if (length <= 0) {
+                throw std::invalid_argument("can't watch " + dir);
+            }
+            for (char *p = buf; p < buf + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event *>(p)->len) {
+                auto event = reinterpret_cast<inotify_event *>(p);
+                if (event->len > 0 && base == event->name && !(event->mask & IN_CREATE)) {
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::string dir;
+    std::string base;
+    int fd = -1;
+};
+
+void watch(const std::string& input_file_name, const std::string& output_file_name, const Options& options) {
+    if (!options.range.is_full() || options.compression != Compression::NONE || !options.print_text ||
+            !options.print_symtab) {
+        throw std::invalid_argument("--watch can't be combined with a text range, compression or section selection");
+    }
+    if (!is_listing(options) || !options.line_index.empty() || options.stats) {
+        throw std::invalid_argument("--watch only updates the listing, it can't be combined with reports, "
+                                    "--functions, --line-index or --stats");
+    }
+    {
+        std::ifstream in(input_file_name, std::ios::binary);
+        in.exceptions(std::ifstream::failbit | std::ifstream::eofbit);
+        if (is_archive(in)) {
+            throw std::invalid_argument("--watch can't be used on archives");
+        }
+    }
+    ChangeWatcher watcher(input_file_name);
+    WatchCache cache;
+    while (true) {
+        try {
+            update_output(input_file_name, output_file_name, options, cache);
+        } catch (const std::invalid_argument& e) {
+            std::cout << "Error: " << e.what() << std::endl;
+        } catch (const std::ios_base::failure& e) {
+            std::cout << "Failed to read input file: " << e.what() << std::endl;
+        }
+        watcher.wait();
+    }
+}
+
+#else
+
+void watch(const std::string&, const std::string&, const Options&) {
+    throw std::invalid_argument("--watch is only supported on Linux");
+}
+
+#endif
+
+}
@@ -0,0 +1,192 @@
+#include "worker.h"
+#include "driver.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Parser {
+
+template <typename T>
+class BlockingQueue {
+public:
+    void push(T value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(value));
+        }
+        not_empty.notify_one();
+    }
+
+    // returns false once the queue is closed and drained
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !queue.empty() || closed; });
+        if (queue.empty()) {
+            return false;
+        }
+        value = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_empty.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::deque<T> queue;
+    bool closed = false;
+};
+
+// larger frames are answered with an error and skipped, not buffered
+const std::uint32_t MAX_REQUEST_SIZE = 1 << 20;
+
+static std::string process_request(const std::vector<std::string>& args) {
+    try {
+        if (args.size() < 2) {
+            throw std::invalid_argument("wrong number of arguments.");
+        }
+        auto options = parse_options(std::vector<std::string>(args.begin() + 2, args.end()));
+        if (options.watch || options.worker != WorkerProtocol::NONE) {
+            throw std::invalid_argument("--watch and --worker can't be used inside a request");
+        }
+
+        run(args[0], args[1], options);
+    } catch (const std::invalid_argument& e) {
+        return std::string("ERROR ") + e.what();
+    } catch (const std::ios_base::failure& e) {
+        return std::string("ERROR failed to read input file: ") + e.what();
+    } catch (const std::exception& e) {
+        // a failed request must not take the worker and the other requests down
+        return std::string("ERROR ") + e.what();
+    } catch (...) {
+        return "ERROR unknown failure";
+    }
+    return "OK";
+}
+
+// reads the next request into args, or sets error for a request that can't be served
+static bool read_request(std::istream& requests, WorkerProtocol protocol, std::vector<std::string>& args,
+                         std::string& error) {
+    args.clear();
+    error.clear();
+    if (protocol == WorkerProtocol::LINES) {
+        std::string line;
+        while (args.empty()) {
+            if (!std::getline(requests, line)) {
+                return false;
+            }
+            std::istringstream tokens(line);
+            std::string arg;
+            while (tokens >> arg) {
+                args.push_back(arg);
+            }
+        }
+        return true;
+    }
+    unsigned char length_bytes[4];
+    if (!requests.read(reinterpret_cast<char *>(length_bytes), sizeof(length_bytes))) {
+        return false;
+    }
+    std::uint32_t length = length_bytes[0] | (length_bytes[1] << 8) | (length_bytes[2] << 16) |
+            (static_cast<std::uint32_t>(length_bytes[3]) << 24);
+    if (length > MAX_REQUEST_SIZE) {
+        error = "ERROR request of " + std::to_string(length) + " bytes is too long";
+        return static_cast<bool>(requests.ignore(length));
+    }
+    std::string payload(length, '\0');
+    if (!requests.read(&payload[0], length)) {
+        return false;
+    }
+    std::size_t start = 0;
+    while (start < payload.size()) {
+        auto end = payload.find('\0', start);
+        if (end == std::string::npos) {
+            end = payload.size();
+        }
+        if (end > start) {
+            args.push_back(payload.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+static void write_response(std::ostream& responses, WorkerProtocol protocol, const std::string& response) {
+    if (protocol == WorkerProtocol::LINES) {
+        responses << response << '\n';
+    } else {
+        auto length = static_cast<std::uint32_t>(response.size());
+        char length_bytes[4] = {
+            static_cast<char>(length & 0xff),
+            static_cast<char>((length >> 8) & 0xff),
+            static_cast<char>((length >> 16) & 0xff),
+            static_cast<char>(length >> 24)
+        };
+        responses.write(length_bytes, sizeof(length_bytes));
+        responses.write(response.data(), static_cast<std::streamsize>(response.size()));
+    }
+    responses.flush();
+}
+
+void run_worker(std::istream& requests, std::ostream& responses, const Options& options) {
+    std::vector<std::string> args;
+    std::string error;
+    if (options.jobs <= 1) {
+        while (read_request(requests, options.worker, args, error)) {
+            write_response(responses, options.worker, error.empty() ? process_request(args) : error);
+        }
+        return;
+    }
+
+    BlockingQueue<std::packaged_task<std::string()>> tasks;
+    BlockingQueue<std::future<std::string>> results;
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < options.jobs; i++) {
+        workers.emplace_back([&tasks] {
+            std::packaged_task<std::string()> task;
+            while (tasks.pop(task)) {
+                task();
+            }
+        });
+    }
+    std::thread writer([&results, &responses, &options] {
+        std::future<std::string> result;
+        while (results.pop(result)) {
+            write_response(responses, options.worker, result.get());
+        }
+    });
+
+    while (read_request(requests, options.worker, args, error)) {
+        std::packaged_task<std::string()> task;
+        if (error.empty()) {
+            task = std::packaged_task<std::string()>(std::bind(process_request, args));
+        } else {
+            task = std::packaged_task<std::string()>([error] { return error; });
+        }
+        results.push(task.get_future());
+        tasks.push(std::move(task));
+    }
+    tasks.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    results.close();
+    writer.join();
+}
+
+}
@@ -0,0 +1,202 @@
+// Relocatable object built with -ffunction-sections: fa and fb live in two .text sections that both
+// start at address 0, so only st_shndx tells their code apart.
+#include "call_graph.h"
+#include "dead_code.h"
+#include "elf_parser.h"
+#include "function_filter.h"
+#include "rvc_report.h"
+#include "size_report.h"
+#include "stack_report.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Parser;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what, const std::string& output) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n" << output << "\n";
+        failures++;
+    }
+}
+
+static std::size_t count(const std::string& s, const std::string& part) {
+    std::size_t result = 0;
+    for (auto at = s.find(part); at != std::string::npos; at = s.find(part, at + 1)) {
+        result++;
+    }
+    return result;
+}
+
+template <typename T>
+static void append(std::string& file, const T& value) {
+    file.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// sections are numbered from 1 in the order they are added
+struct ElfBuilder {
+    std::string file = std::string(sizeof(ELF32_header), '\0');
+    std::vector<Elf32_section_header> headers = std::vector<Elf32_section_header>(1, Elf32_section_header{});
+
+    // the header stays valid until the next add
+    Elf32_section_header& add(std::uint32_t type, std::uint32_t flags, const std::string& data) {
+        Elf32_section_header s_header{};
+        s_header.sh_type = type;
+        s_header.sh_flags = flags;
+        s_header.sh_offset = file.size();
+        s_header.sh_size = data.size();
+        file += data;
+        file.resize((file.size() + 3) / 4 * 4, '\0');
+        headers.push_back(s_header);
+        return headers.back();
+    }
+
+    std::string finish(std::uint16_t type) {
+        ELF32_header header{};
+        std::memcpy(header.e_ident, "\x7f" "ELF\x01\x01\x01", 7);
+        header.e_type = type;
+        header.e_machine = 0xf3;
+        header.e_version = 1;
+        header.e_shoff = file.size();
+        header.e_ehsize = sizeof(ELF32_header);
+        header.e_shentsize = sizeof(Elf32_section_header);
+        header.e_shnum = headers.size();
+        std::memcpy(&file[0], &header, sizeof(header));
+        for (const auto& s_header : headers) {
+            append(file, s_header);
+        }
+        return file;
+    }
+};
+
+static std::string build_object() {
+    // fa: addi a0, a0, 1; c.jr ra                                 - one compressible 32-bit command
+    // fe: jal ra, fa; c.jr ra                                     - fa, not fb, which is also at 0
+    // fb: lui a0, 0x12345; addi a0, a0, 1000; jalr zero, 4(ra)    - three 32-bit commands, none compressible
+    // fc: auipc ra, 0; jalr ra, 0(ra); jal ra, 0; c.jr ra         - relocated calls of fa and of extern ext
+    std::string text_a, text_b, text_c;
+    append(text_a, std::uint32_t(0x00150513));
+    append(text_a, std::uint16_t(0x8082));
+    append(text_a, std::uint32_t(0xffbff0ef));
+    append(text_a, std::uint16_t(0x8082));
+    append(text_b, std::uint32_t(0x12345537));
+    append(text_b, std::uint32_t(0x3e850513));
+    append(text_b, std::uint32_t(0x00408067));
+    append(text_c, std::uint32_t(0x00000097));
+    append(text_c, std::uint32_t(0x000080e7));
+    append(text_c, std::uint32_t(0x000000ef));
+    append(text_c, std::uint16_t(0x8082));
+    std::string strtab("\0fa\0fb\0fe\0fc\0ext\0", 17);
+    std::string symtab;
+    append(symtab, Elf32_Sym{0, 0, 0, 0, 0, 0});
+    append(symtab, Elf32_Sym{1, 0, 6, (STB_GLOBAL << 4) | STT_FUNC, 0, 1});
+    append(symtab, Elf32_Sym{4, 0, 12, (STB_GLOBAL << 4) | STT_FUNC, 0, 2});
+    append(symtab, Elf32_Sym{7, 6, 6, (STB_GLOBAL << 4) | STT_FUNC, 0, 1});
+    append(symtab, Elf32_Sym{10, 0, 14, (STB_GLOBAL << 4) | STT_FUNC, 0, 5});
+    append(symtab, Elf32_Sym{13, 0, 0, STB_GLOBAL << 4, 0, 0});
+    std::string rela;
+    append(rela, Elf32_Rela{0, (1 << 8) | R_RISCV_CALL_PLT, 0});
+    append(rela, Elf32_Rela{8, (5 << 8) | R_RISCV_JAL, 0});
+
+    ElfBuilder elf;
+    elf.add(TEXT_TYPE, SHF_EXECINSTR, text_a);
+    elf.add(TEXT_TYPE, SHF_EXECINSTR, text_b);
+    auto& symtab_header = elf.add(SYMTAB_TYPE, 0, symtab);
+    symtab_header.sh_link = 4;
+    symtab_header.sh_entsize = sizeof(Elf32_Sym);
+    elf.add(STRTAB_TYPE, 0, strtab);
+    elf.add(TEXT_TYPE, SHF_EXECINSTR, text_c);
+    auto& rela_header = elf.add(RELA_TYPE, 0, rela);
+    rela_header.sh_link = 3;
+    rela_header.sh_info = 5;
+    return elf.finish(ET_REL);
+}
+
+// Executable whose main takes the address of a local function with c.lui and addi and calls it.
+static std::string build_executable() {
+    // 10000 main: c.lui a0, 0x10; addi a0, a0, 10; c.jalr a0; c.jr ra
+    // 1000a handler: c.jr ra
+    // 1000c dead: c.jr ra
+    std::string text;
+    append(text, std::uint16_t(0x6541));
+    append(text, std::uint32_t(0x00a50513));
+    append(text, std::uint16_t(0x9502));
+    append(text, std::uint16_t(0x8082));
+    append(text, std::uint16_t(0x8082));
+    append(text, std::uint16_t(0x8082));
+    std::string strtab("\0main\0handler\0dead\0", 19);
+    std::string symtab;
+    append(symtab, Elf32_Sym{0, 0, 0, 0, 0, 0});
+    append(symtab, Elf32_Sym{1, 0x10000, 10, (STB_GLOBAL << 4) | STT_FUNC, 0, 1});
+    append(symtab, Elf32_Sym{6, 0x1000a, 2, STT_FUNC, 0, 1});
+    append(symtab, Elf32_Sym{14, 0x1000c, 2, STT_FUNC, 0, 1});
+
+    ElfBuilder elf;
+    elf.add(TEXT_TYPE, SHF_EXECINSTR, text).sh_addr = 0x10000;
+    auto& symtab_header = elf.add(SYMTAB_TYPE, 0, symtab);
+    symtab_header.sh_link = 3;
+    symtab_header.sh_entsize = sizeof(Elf32_Sym);
+    elf.add(STRTAB_TYPE, 0, strtab);
+    return elf.finish(ET_EXEC);
+}
+
+int main() {
+    auto object = build_object();
+
+    std::istringstream in(object);
+    std::ostringstream sizes;
+    report_sizes(in, sizes, SizeReport::TABLE, 2);
+    auto output = sizes.str();
+    check(count(output, "  fa:") == 1 && count(output, "  fb:") == 1, "size report lists every function once", output);
+    check(output.find("00000000        6        2") != std::string::npos, "fa has 6 bytes in 2 commands", output);
+    check(output.find("00000000       12        3") != std::string::npos, "fb has 12 bytes in 3 commands", output);
+
+    in.clear();
+    std::ostringstream rvc;
+    report_rvc(in, rvc, 2);
+    output = rvc.str();
+    check(output.find("fa: 1 of 1 32-bit") != std::string::npos, "fa is decoded from its own section", output);
+    check(output.find("fb: 0 of 3 32-bit") != std::string::npos, "fb is decoded from its own section", output);
+
+    in.clear();
+    std::ostringstream listing;
+    Options options;
+    options.functions = "f*";
+    options.jobs = 2;
+    disassemble_functions(in, listing, options);
+    output = listing.str();
+    check(count(output, " fa: ") == 1 && count(output, " fb: ") == 1, "function listing shows every function once", output);
+    check(output.find("fa: addi a0, a0, 1") != std::string::npos, "fa is listed from its own section", output);
+    check(output.find("fb: lui a0, 305418240") != std::string::npos, "fb is listed from its own section", output);
+
+    in.clear();
+    std::ostringstream graph;
+    export_call_graph(in, graph, CallGraphFormat::DOT, 2);
+    output = graph.str();
+    check(output.find("\"fe\" -> \"fa\"") != std::string::npos,
+          "a call is resolved inside the section of its caller", output);
+    check(output.find("\"fc\" -> \"fa\"") != std::string::npos && count(output, " -> ") == 2,
+          "calls go where their relocations say, not to the unrelocated offset 0", output);
+
+    in.clear();
+    std::ostringstream stack;
+    report_stack(in, stack);
+    output = stack.str();
+    check(output.find("recursion") == std::string::npos, "unrelocated calls are not recursion", output);
+
+    std::istringstream executable(build_executable());
+    std::ostringstream unreferenced;
+    report_unreferenced(executable, unreferenced, 2);
+    output = unreferenced.str();
+    check(output.find("handler") == std::string::npos, "an address built with c.lui keeps handler alive", output);
+    check(output.find("dead") != std::string::npos, "dead is reported", output);
+
+    if (failures == 0) {
+        std::cout << "all checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}